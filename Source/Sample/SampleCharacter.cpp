@@ -1,16 +1,32 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SampleCharacter.h"
+#include "Sample.h"
 #include "PaperFlipbookComponent.h"
 #include "Components/TextRenderComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "SampleCharacterMovementComponent.h"
+#include "SampleSpriteBatchSubsystem.h"
+#include "SampleMemoryReport.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "Camera/CameraComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Camera/PlayerCameraManager.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Animation"), STAT_SampleUpdateAnimation, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Animation LOD Full"), STAT_SampleAnimationLODFull, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Animation LOD Reduced"), STAT_SampleAnimationLODReduced, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Animation LOD Paused"), STAT_SampleAnimationLODPaused, STATGROUP_Sample);
+
+static TAutoConsoleVariable<int32> CVarSampleAnimationLOD(
+	TEXT("Sample.AnimationLOD"),
+	1,
+	TEXT("If 0, animations of every character are updated each frame regardless of visibility and distance."),
+	ECVF_Default);
 
 //////////////////////////////////////////////////////////////////////////
 // ASampleCharacter
@@ -67,50 +83,266 @@ ASampleCharacter::ASampleCharacter(const FObjectInitializer& ObjectInitializer)
 	// Enable replication on the Sprite component so animations show up when networked
 	GetSprite()->SetIsReplicated(true);
 	bReplicates = true;
+
+	// Animation LOD
+	AnimationLODDistance = 1024.0f;
+	ReducedAnimationUpdateInterval = 0.1f;
+	AnimationVisibilityTolerance = 0.2f;
+	AnimationLOD = ESampleAnimationLOD::Full;
+	AnimationUpdateAccumulator = 0.0f;
+	AnimationPausedTime = 0.0f;
+	bSpriteBatched = false;
+	SpriteBaseLocation = FVector::ZeroVector;
 }
 
 void ASampleCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	SpriteBaseLocation = GetSprite()->GetRelativeLocation();
+
 	APlayerController* PlayerController = (APlayerController*)Controller;
 
 	if (PlayerController)
 	{
 		PlayerController->ConsoleCommand(TEXT("r.SetRes 512x448w"));
 	}
+
+	// Simulated proxies can be drawn by a shared sprite batch instead of their own flipbook
+	if (GetLocalRole() == ROLE_SimulatedProxy && USampleSpriteBatchSubsystem::IsEnabled())
+	{
+		if (USampleSpriteBatchSubsystem* SpriteBatchSubsystem = GetWorld()->GetSubsystem<USampleSpriteBatchSubsystem>())
+		{
+			SpriteBatchSubsystem->AddCharacter(this);
+		}
+	}
+}
+
+void ASampleCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bSpriteBatched)
+	{
+		if (USampleSpriteBatchSubsystem* SpriteBatchSubsystem = GetWorld()->GetSubsystem<USampleSpriteBatchSubsystem>())
+		{
+			SpriteBatchSubsystem->RemoveCharacter(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASampleCharacter::SetSpriteBatched(bool bIsBatched)
+{
+	if (bSpriteBatched == bIsBatched)
+	{
+		return;
+	}
+
+	bSpriteBatched = bIsBatched;
+
+	// Remove the sprite from the scene and from ticking while the batch draws it
+	UPaperFlipbookComponent* Sprite = GetSprite();
+	if (bSpriteBatched && Sprite->IsRegistered())
+	{
+		Sprite->UnregisterComponent();
+	}
+	else if (!bSpriteBatched && !Sprite->IsRegistered() && !IsActorBeingDestroyed())
+	{
+		Sprite->RegisterComponent();
+	}
+}
+
+void ASampleCharacter::SetSpriteSmoothingOffset(const FVector& WorldOffset)
+{
+	GetSprite()->SetRelativeLocation(SpriteBaseLocation + GetActorTransform().InverseTransformVectorNoScale(WorldOffset));
+}
+
+void ASampleCharacter::GatherMemoryUsage(FSampleCharacterMemory& OutMemory)
+{
+	OutMemory.Add(ESampleMemoryCategory::Actor, GetClass()->GetStructureSize() + GetResourceSizeBytes(EResourceSizeMode::Exclusive), 1);
+
+	// A set allocates its elements and its hash
+	OutMemory.Add(ESampleMemoryCategory::Volumes, Volumes.GetAllocatedSize(), Volumes.GetAllocatedSize() > 0 ? 2 : 0);
+
+	for (UActorComponent* Component : GetComponents())
+	{
+		ESampleMemoryCategory Category = ESampleMemoryCategory::OtherComponents;
+		if (Component == GetSprite())
+		{
+			Category = ESampleMemoryCategory::Sprite;
+		}
+		else if (Component == SideViewCameraComponent)
+		{
+			Category = ESampleMemoryCategory::Camera;
+		}
+
+		OutMemory.Add(Category, Component->GetClass()->GetStructureSize() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive), 1);
+	}
+
+	if (USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(GetMovementComponent()))
+	{
+		MoveComponent->GatherPredictionMemoryUsage(OutMemory);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
 // Animation
 
-void ASampleCharacter::UpdateAnimation()
+ESampleAnimationState ASampleCharacter::GetAnimationState() const
 {
 	const FVector PlayerVelocity = GetVelocity();
 	const float PlayerSpeedSqr = PlayerVelocity.SizeSquared();
 
-	UPaperFlipbook* DesiredAnimation = nullptr;
 	USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(GetMovementComponent());
 	if (MoveComponent && MoveComponent->IsClimbing())
 	{
-		DesiredAnimation = (PlayerSpeedSqr > 0.0f) ? ClimbingRunningAnimation : ClimbingIdleAnimation;
+		return (PlayerSpeedSqr > 0.0f) ? ESampleAnimationState::ClimbingRunning : ESampleAnimationState::ClimbingIdle;
 	}
-	else
+
+	return (PlayerSpeedSqr > 0.0f) ? ESampleAnimationState::Running : ESampleAnimationState::Idle;
+}
+
+UPaperFlipbook* ASampleCharacter::GetAnimationFlipbook(ESampleAnimationState State) const
+{
+	switch (State)
+	{
+	case ESampleAnimationState::Running: return RunningAnimation;
+	case ESampleAnimationState::ClimbingIdle: return ClimbingIdleAnimation;
+	case ESampleAnimationState::ClimbingRunning: return ClimbingRunningAnimation;
+	default: return IdleAnimation;
+	}
+}
+
+UPaperFlipbook* ASampleCharacter::GetDesiredAnimation() const
+{
+	return GetAnimationFlipbook(GetAnimationState());
+}
+
+void ASampleCharacter::SetReplayState(const FVector& Location, bool bFacingLeft, ESampleAnimationState State)
+{
+	SetActorLocationAndRotation(Location, FRotator(0.0f, bFacingLeft ? 180.0f : 0.0f, 0.0f));
+
+	UPaperFlipbook* Flipbook = GetAnimationFlipbook(State);
+	if (Flipbook && GetSprite()->GetFlipbook() != Flipbook)
 	{
-		DesiredAnimation = (PlayerSpeedSqr > 0.0f) ? RunningAnimation : IdleAnimation;
+		GetSprite()->SetFlipbook(Flipbook);
 	}
+}
+
+void ASampleCharacter::UpdateAnimation()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleUpdateAnimation);
 
+	UPaperFlipbook* DesiredAnimation = GetDesiredAnimation();
 	if(DesiredAnimation && GetSprite()->GetFlipbook() != DesiredAnimation 	)
 	{
 		GetSprite()->SetFlipbook(DesiredAnimation);
 	}
 }
 
+ESampleAnimationLOD ASampleCharacter::ComputeAnimationLOD() const
+{
+	// Always animate the character of a local player
+	if (CVarSampleAnimationLOD.GetValueOnGameThread() == 0 || (IsLocallyControlled() && IsPlayerControlled()))
+	{
+		return ESampleAnimationLOD::Full;
+	}
+
+	// The flipbook is culled by the orthographic camera, or we are a dedicated server
+	if (!GetSprite()->WasRecentlyRendered(AnimationVisibilityTolerance))
+	{
+		return ESampleAnimationLOD::Paused;
+	}
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		const FVector Delta = GetActorLocation() - PlayerController->PlayerCameraManager->GetCameraLocation();
+		if (FVector2D(Delta.X, Delta.Z).SizeSquared() > FMath::Square(AnimationLODDistance))
+		{
+			return ESampleAnimationLOD::Reduced;
+		}
+	}
+
+	return ESampleAnimationLOD::Full;
+}
+
+void ASampleCharacter::SetAnimationLOD(ESampleAnimationLOD NewLOD)
+{
+	if (NewLOD == AnimationLOD)
+	{
+		return;
+	}
+
+	UPaperFlipbookComponent* Sprite = GetSprite();
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	if (NewLOD == ESampleAnimationLOD::Paused)
+	{
+		// Stop ticking the flipbook, it keeps rendering its current frame
+		Sprite->SetComponentTickEnabled(false);
+		AnimationPausedTime = CurrentTime;
+	}
+	else
+	{
+		if (AnimationLOD == ESampleAnimationLOD::Paused)
+		{
+			// Select the flipbook matching the current motion, then jump to the frame
+			// it would be showing if it had kept playing while off-screen
+			UpdateAnimation();
+
+			const float FlipbookLength = Sprite->GetFlipbookLength();
+			if (Sprite->IsPlaying() && Sprite->IsLooping() && FlipbookLength > 0.0f)
+			{
+				const float Elapsed = (CurrentTime - AnimationPausedTime) * Sprite->GetPlayRate();
+				const float Position = FMath::Fmod(Sprite->GetPlaybackPosition() + Elapsed, FlipbookLength);
+				Sprite->SetPlaybackPosition(Position < 0.0f ? Position + FlipbookLength : Position, false);
+			}
+
+			Sprite->SetComponentTickEnabled(true);
+		}
+
+		// The flipbook receives the whole elapsed time when ticking at an interval
+		Sprite->SetComponentTickInterval(NewLOD == ESampleAnimationLOD::Reduced ? ReducedAnimationUpdateInterval : 0.0f);
+	}
+
+	AnimationUpdateAccumulator = 0.0f;
+	AnimationLOD = NewLOD;
+}
+
+bool ASampleCharacter::ShouldUpdateAnimation(float DeltaSeconds)
+{
+	switch (AnimationLOD)
+	{
+	case ESampleAnimationLOD::Paused:
+		INC_DWORD_STAT(STAT_SampleAnimationLODPaused);
+		return false;
+	case ESampleAnimationLOD::Reduced:
+		INC_DWORD_STAT(STAT_SampleAnimationLODReduced);
+		AnimationUpdateAccumulator += DeltaSeconds;
+		if (AnimationUpdateAccumulator < ReducedAnimationUpdateInterval)
+		{
+			return false;
+		}
+		AnimationUpdateAccumulator = 0.0f;
+		return true;
+	default:
+		INC_DWORD_STAT(STAT_SampleAnimationLODFull);
+		return true;
+	}
+}
+
 void ASampleCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
-	
-	UpdateCharacter();	
+
+	// The sprite batch selects and plays the flipbook itself
+	if (!bSpriteBatched)
+	{
+		SetAnimationLOD(ComputeAnimationLOD());
+	}
+
+	UpdateCharacter(DeltaSeconds);
 }
 
 
@@ -145,10 +377,13 @@ void ASampleCharacter::MoveUp(float Value)
 	}
 }
 
-void ASampleCharacter::UpdateCharacter()
+void ASampleCharacter::UpdateCharacter(float DeltaSeconds)
 {
 	// Update animation to match the motion
-	UpdateAnimation();
+	if (!bSpriteBatched && ShouldUpdateAnimation(DeltaSeconds))
+	{
+		UpdateAnimation();
+	}
 
 	// Now setup the rotation of the controller based on the direction we are travelling
 	const FVector PlayerVelocity = GetVelocity();
@@ -201,6 +436,9 @@ void ASampleCharacter::StartClimb()
 		if (CanClimb())
 		{
 			MoveComponent->bWantsToClimb = true;
+
+			// Remember the press for a tap released before reaching a wall
+			MoveComponent->BufferClimbInput();
 		}
 	}
 }
@@ -215,6 +453,19 @@ void ASampleCharacter::StopClimb()
 	}
 }
 
+bool ASampleCharacter::CanJumpInternal_Implementation() const
+{
+	// Jumping during the coyote time after leaving a wall counts as jumping off the wall,
+	// not as an extra jump in the air
+	USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(GetMovementComponent());
+	if (MoveComponent && MoveComponent->IsInClimbCoyoteTime() && JumpCurrentCount == 0)
+	{
+		return true;
+	}
+
+	return Super::CanJumpInternal_Implementation();
+}
+
 bool ASampleCharacter::CanClimb() const
 {
 	USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(GetMovementComponent());
@@ -8,6 +8,29 @@
 
 class UTextRenderComponent;
 class ASampleClimbableVolume;
+struct FSampleCharacterMemory;
+
+/** How often the sprite animation of a character is updated */
+UENUM()
+enum class ESampleAnimationLOD : uint8
+{
+	/** Visible and close to the view, updated every frame */
+	Full,
+	/** Visible but far from the view, updated at ReducedAnimationUpdateInterval */
+	Reduced,
+	/** Not rendered, flipbook selection and playback are paused */
+	Paused
+};
+
+/** Which flipbook the character plays */
+UENUM()
+enum class ESampleAnimationState : uint8
+{
+	Idle,
+	Running,
+	ClimbingIdle,
+	ClimbingRunning
+};
 
 /**
  * This class is the default character for Sample, and it is responsible for all
@@ -26,6 +49,7 @@ public:
 	ASampleCharacter(const FObjectInitializer& ObjectInitializer);
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/** Returns SideViewCameraComponent subobject **/
 	FORCEINLINE class UCameraComponent* GetSideViewCameraComponent() const { return SideViewCameraComponent; }
@@ -46,12 +70,40 @@ public:
 	UFUNCTION(BlueprintCallable, Category=Character)
 	virtual bool CanClimb() const;
 
+	/** @return the animation state matching the current motion */
+	ESampleAnimationState GetAnimationState() const;
+
+	/** @return the flipbook played in an animation state */
+	class UPaperFlipbook* GetAnimationFlipbook(ESampleAnimationState State) const;
+
+	/** @return the flipbook matching the current motion */
+	class UPaperFlipbook* GetDesiredAnimation() const;
+
+	/** Called by USampleSpriteBatchSubsystem when this character starts or stops being drawn by a sprite batch */
+	void SetSpriteBatched(bool bIsBatched);
+
+	/** Draw the sprite away from the capsule, used to smooth simulated proxies */
+	void SetSpriteSmoothingOffset(const FVector& WorldOffset);
+
+	/** Display a recorded state, used by the ghosts of USampleReplaySubsystem */
+	void SetReplayState(const FVector& Location, bool bFacingLeft, ESampleAnimationState State);
+
+	/** Add the memory used by this character, its components and its movement prediction data */
+	void GatherMemoryUsage(FSampleCharacterMemory& OutMemory);
+
 protected:
 	void UpdateAnimation();
 	void MoveRight(float Value);
 	void MoveUp(float Value);
-	void UpdateCharacter();
+	void UpdateCharacter(float DeltaSeconds);
+	/** Compute which animation LOD this character should use this frame */
+	ESampleAnimationLOD ComputeAnimationLOD() const;
+	/** Pause, throttle or resume the flipbook when the animation LOD changes */
+	void SetAnimationLOD(ESampleAnimationLOD NewLOD);
+	/** @return true if the flipbook selection should run this frame */
+	bool ShouldUpdateAnimation(float DeltaSeconds);
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
+	virtual bool CanJumpInternal_Implementation() const override;
 	
 	// The animation to play while running around
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Animations)
@@ -69,6 +121,18 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations)
 	class UPaperFlipbook* ClimbingIdleAnimation;
 
+	// Distance from the view, in the XZ plane, above which the animation is updated at a reduced rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations, meta = (ClampMin = "0", UIMin = "0"))
+	float AnimationLODDistance;
+
+	// Interval between two animation updates when far from the view
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations, meta = (ClampMin = "0", UIMin = "0"))
+	float ReducedAnimationUpdateInterval;
+
+	// How long the sprite can stay unrendered before its animation is paused
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations, meta = (ClampMin = "0", UIMin = "0"))
+	float AnimationVisibilityTolerance;
+
 private:
 	/** Side view camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera, meta=(AllowPrivateAccess="true"))
@@ -80,4 +144,19 @@ private:
 	/** Store overlapping volumes */
 	UPROPERTY(transient)
 	TSet<ASampleClimbableVolume*> Volumes;
+
+	/** Current animation LOD */
+	ESampleAnimationLOD AnimationLOD;
+
+	/** Time accumulated since the last animation update when in ESampleAnimationLOD::Reduced */
+	float AnimationUpdateAccumulator;
+
+	/** World time at which the animation was paused, used to catch up when visible again */
+	float AnimationPausedTime;
+
+	/** If true, the sprite is unregistered and the character is drawn by a sprite batch */
+	bool bSpriteBatched;
+
+	/** Relative location of the sprite without smoothing offset */
+	FVector SpriteBaseLocation;
 };
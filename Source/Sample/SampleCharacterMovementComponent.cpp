@@ -1,7 +1,16 @@
 #include "SampleCharacterMovementComponent.h"
+#include "Sample.h"
 #include "SampleCharacter.h"
+#include "SampleMemoryReport.h"
 #include "GameFramework/Character.h"
 
+DECLARE_CYCLE_STAT(TEXT("Climb Proxy Smoothing"), STAT_SampleClimbProxySmoothing, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Climb Smoothed Proxies"), STAT_SampleClimbSmoothedProxies, STATGROUP_Sample);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Climb Input Latency Local (frames)"), STAT_SampleClimbLatencyLocalFrames, STATGROUP_Sample);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Climb Input Latency Local (ms)"), STAT_SampleClimbLatencyLocalMs, STATGROUP_Sample);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Climb Input Latency Server (frames)"), STAT_SampleClimbLatencyServerFrames, STATGROUP_Sample);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Climb Input Latency Server (ms)"), STAT_SampleClimbLatencyServerMs, STATGROUP_Sample);
+
 USampleCharacterMovementComponent::USampleCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
     , bClimbEnabled(false)
@@ -9,7 +18,21 @@ USampleCharacterMovementComponent::USampleCharacterMovementComponent(const FObje
     , ClimbCooldown(0.0f)
     , ClimbTimer(0.0f)
     , bWantsToClimb(false)
-{}
+    , ClimbGrabWindow(0.15f)
+    , ClimbCoyoteTime(0.1f)
+    , ClimbGrabTimer(0.0f)
+    , ClimbCoyoteTimer(0.0f)
+    , bClimbLatencyPending(false)
+    , ClimbLatencyStartFrame(0)
+    , ClimbLatencyStartTime(0.0)
+{
+    bUseClimbSmoothing = true;
+    ClimbSmoothingDelay = 0.1f;
+    ClimbSmoothingMaxExtrapolation = 0.25f;
+
+    // The climb smoothing needs the server time of each update
+    bNetworkAlwaysReplicateTransformUpdateTimestamp = true;
+}
 
 float USampleCharacterMovementComponent::GetMaxSpeed() const
 {
@@ -33,7 +56,7 @@ float USampleCharacterMovementComponent::GetMaxBrakingDeceleration() const
 
 bool USampleCharacterMovementComponent::CanAttemptJump() const
 {
-    if (CanEverJump() && IsClimbing())
+    if (CanEverJump() && (IsClimbing() || IsInClimbCoyoteTime()))
     {
         return true;
     }
@@ -52,6 +75,9 @@ bool USampleCharacterMovementComponent::DoJump(bool bReplayingMoves)
             ClimbTimer = ClimbCooldown;
         }
 
+        // Coyote jump is consumed
+        ClimbCoyoteTimer = 0.0f;
+
         return true;
     }
 
@@ -71,18 +97,35 @@ void USampleCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float
         }
     }
 
+    ClimbGrabTimer = FMath::Max(ClimbGrabTimer - DeltaSeconds, 0.0f);
+    ClimbCoyoteTimer = FMath::Max(ClimbCoyoteTimer - DeltaSeconds, 0.0f);
+
     // Proxies get replicated climb state.
     if (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
     {
-        // Check for a change in climb state. Players toggle climb by changing bWantsToClimb.
+        // Check for a change in climb state. Players toggle climb by changing bWantsToClimb,
+        // a buffered press can also start climbing.
         const bool bIsClimbing = IsClimbing();
         if (bIsClimbing && (!bWantsToClimb || !CanClimbInCurrentState()))
         {
             UnClimb(false);
         }
-        else if (!bIsClimbing && bWantsToClimb && CanClimbInCurrentState())
+        else if (!bIsClimbing && (bWantsToClimb || ClimbGrabTimer > 0.0f) && CanClimbInCurrentState())
         {
             Climb(false);
+
+            // A grab from a buffered press survives the release of the button, the
+            // player lets go with the next release of Climb
+            if (IsClimbing())
+            {
+                bWantsToClimb = true;
+            }
+        }
+
+        // The input was dropped before reaching a wall
+        if (bClimbLatencyPending && !bWantsToClimb && ClimbGrabTimer <= 0.0f)
+        {
+            bClimbLatencyPending = false;
         }
     }
 }
@@ -112,6 +155,22 @@ bool USampleCharacterMovementComponent::IsClimbing() const
     return (MovementMode == MOVE_Custom && CustomMovementMode == (uint8)ESampleMovementMode::MOVE_Climbing) && UpdatedComponent;
 }
 
+bool USampleCharacterMovementComponent::IsInClimbCoyoteTime() const
+{
+    return ClimbCoyoteTimer > 0.0f && IsFalling();
+}
+
+void USampleCharacterMovementComponent::BufferClimbInput()
+{
+    if (IsClimbing())
+    {
+        return;
+    }
+
+    ClimbGrabTimer = ClimbGrabWindow;
+    StartClimbLatencyMeasure();
+}
+
 void USampleCharacterMovementComponent::Climb(bool bClientSimulation)
 {
 	if (!HasValidData())
@@ -141,6 +200,7 @@ void USampleCharacterMovementComponent::UnClimb(bool bClientSimulation)
     ASampleCharacter* Owner = StaticCast<ASampleCharacter*>(CharacterOwner);
     SetMovementMode(EMovementMode::MOVE_Falling);
     ClimbTimer = ClimbCooldown;
+    ClimbCoyoteTimer = ClimbCoyoteTime;
 }
 
 void USampleCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
@@ -209,11 +269,170 @@ void USampleCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
 
     Super::UpdateFromCompressedFlags(Flags);
 
+    const bool bWasClimbInput = bWantsToClimb || ClimbGrabTimer > 0.0f;
     bWantsToClimb = ((Flags & FSavedMove_SampleCharacter::FLAG_ClimbPressed) != 0);
+
+    // Only the state of the buffer is sent, restart it when it changes. When replaying
+    // moves the saved timer already matches the flag.
+    const bool bClimbBuffered = ((Flags & FSavedMove_SampleCharacter::FLAG_ClimbBuffered) != 0);
+    if (bClimbBuffered != (ClimbGrabTimer > 0.0f))
+    {
+        ClimbGrabTimer = bClimbBuffered ? ClimbGrabWindow : 0.0f;
+    }
+
+    // Server side, the input starts when the first move carrying it is received
+    if (CharacterOwner->GetLocalRole() == ROLE_Authority && !bWasClimbInput && (bWantsToClimb || bClimbBuffered))
+    {
+        StartClimbLatencyMeasure();
+    }
+}
+
+void USampleCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+    Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+    if (IsClimbing())
+    {
+        // The buffered press is consumed by the grab
+        ClimbGrabTimer = 0.0f;
+        StopClimbLatencyMeasure();
+    }
+}
+
+void USampleCharacterMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
+{
+    Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+
+    if (!bUseClimbSmoothing || !HasValidData() || CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
+    {
+        return;
+    }
+
+    // Don't smooth teleports
+    if (FVector::DistSquared(OldLocation, NewLocation) > FMath::Square(NetworkNoSmoothUpdateDistance))
+    {
+        ProxySmoothing.Reset();
+    }
+
+    // The replicated movement mode is only applied later by SimulatedTick, decode it so
+    // the sample is tagged with the mode of this update rather than the previous one
+    TEnumAsByte<EMovementMode> NetMovementMode(MOVE_None);
+    TEnumAsByte<EMovementMode> NetGroundMode(MOVE_None);
+    uint8 NetCustomMode(0);
+    UnpackNetworkMovementMode(CharacterOwner->GetReplicatedMovementMode(), NetMovementMode, NetCustomMode, NetGroundMode);
+
+    uint8 Mode = FSampleProxySmoothing::ModeGround;
+    if (NetMovementMode == MOVE_Custom && NetCustomMode == (uint8)ESampleMovementMode::MOVE_Climbing)
+    {
+        Mode = FSampleProxySmoothing::ModeClimbing;
+    }
+    else if (NetMovementMode == MOVE_Falling)
+    {
+        Mode = FSampleProxySmoothing::ModeFalling;
+    }
+
+    ProxySmoothing.AddSample(CharacterOwner->GetReplicatedServerLastTransformUpdateTimeStamp(), GetWorld()->GetTimeSeconds(), NewLocation, Velocity, Mode);
+}
+
+void USampleCharacterMovementComponent::SmoothClientPosition(float DeltaSeconds)
+{
+    if (!bUseClimbSmoothing || !HasValidData() || CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
+    {
+        Super::SmoothClientPosition(DeltaSeconds);
+        return;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_SampleClimbProxySmoothing);
+    INC_DWORD_STAT(STAT_SampleClimbSmoothedProxies);
+
+    FVector2D SmoothedLocation;
+    const float Gravity = FMath::Abs(GetGravityZ());
+    if (ProxySmoothing.Evaluate(GetWorld()->GetTimeSeconds(), ClimbSmoothingDelay, ClimbSmoothingMaxExtrapolation, Gravity, SmoothedLocation))
+    {
+        const FVector Location = UpdatedComponent->GetComponentLocation();
+        StaticCast<ASampleCharacter*>(CharacterOwner)->SetSpriteSmoothingOffset(FVector(SmoothedLocation.X, Location.Y, SmoothedLocation.Y) - Location);
+    }
+
+    // Keep being called by SimulatedTick while we have a history
+    bNetworkSmoothingComplete = false;
+}
+
+void USampleCharacterMovementComponent::StartClimbLatencyMeasure()
+{
+    if (bClimbLatencyPending || IsClimbing())
+    {
+        return;
+    }
+
+    bClimbLatencyPending = true;
+    ClimbLatencyStartFrame = GFrameCounter;
+    ClimbLatencyStartTime = FPlatformTime::Seconds();
+}
+
+void USampleCharacterMovementComponent::StopClimbLatencyMeasure()
+{
+    if (!bClimbLatencyPending)
+    {
+        return;
+    }
+
+    bClimbLatencyPending = false;
+
+    const uint32 Frames = (uint32)(GFrameCounter - ClimbLatencyStartFrame);
+    const float Milliseconds = (float)((FPlatformTime::Seconds() - ClimbLatencyStartTime) * 1000.0);
+
+    if (CharacterOwner->IsLocallyControlled())
+    {
+        SET_DWORD_STAT(STAT_SampleClimbLatencyLocalFrames, Frames);
+        SET_FLOAT_STAT(STAT_SampleClimbLatencyLocalMs, Milliseconds);
+        UE_LOG(LogSample, Verbose, TEXT("%s: climb input to MOVE_Climbing took %u frames (%.2f ms) locally"), *GetNameSafe(CharacterOwner), Frames, Milliseconds);
+    }
+    else
+    {
+        SET_DWORD_STAT(STAT_SampleClimbLatencyServerFrames, Frames);
+        SET_FLOAT_STAT(STAT_SampleClimbLatencyServerMs, Milliseconds);
+        UE_LOG(LogSample, Verbose, TEXT("%s: climb input to MOVE_Climbing took %u frames (%.2f ms) on server"), *GetNameSafe(CharacterOwner), Frames, Milliseconds);
+    }
+}
+
+void USampleCharacterMovementComponent::GatherPredictionMemoryUsage(FSampleCharacterMemory& OutMemory) const
+{
+    if (HasPredictionData_Client())
+    {
+        const FNetworkPredictionData_Client_Character* ClientData = ClientPredictionData;
+        OutMemory.Add(ESampleMemoryCategory::ClientPrediction,
+            sizeof(FNetworkPredictionData_Client_SampleCharacter) + ClientData->SavedMoves.GetAllocatedSize() + ClientData->FreeMoves.GetAllocatedSize(),
+            1 + (ClientData->SavedMoves.Max() > 0 ? 1 : 0) + (ClientData->FreeMoves.Max() > 0 ? 1 : 0));
+
+        // Moves can be referenced from several places
+        TSet<const FSavedMove_Character*> Moves;
+        for (const FSavedMovePtr& Move : ClientData->SavedMoves)
+        {
+            Moves.Add(Move.Get());
+        }
+        for (const FSavedMovePtr& Move : ClientData->FreeMoves)
+        {
+            Moves.Add(Move.Get());
+        }
+        Moves.Add(ClientData->PendingMove.Get());
+        Moves.Add(ClientData->LastAckedMove.Get());
+        Moves.Remove(nullptr);
+
+        // Each move is allocated separately from its shared reference controller
+        const int64 SharedReferenceControllerSize = sizeof(void*) + 2 * sizeof(int32);
+        OutMemory.Add(ESampleMemoryCategory::SavedMoves, Moves.Num() * (sizeof(FSavedMove_SampleCharacter) + SharedReferenceControllerSize), Moves.Num() * 2);
+    }
+
+    if (HasPredictionData_Server())
+    {
+        OutMemory.Add(ESampleMemoryCategory::ServerPrediction, sizeof(FNetworkPredictionData_Server_Character), 1);
+    }
 }
 
 FSavedMove_SampleCharacter::FSavedMove_SampleCharacter()
     : ClimbTimer(0.0f)
+    , ClimbGrabTimer(0.0f)
+    , ClimbCoyoteTimer(0.0f)
     , bWantsToClimb(false)
     , ClimbTimerThresholdCombine(0.01f)
 {}
@@ -226,6 +445,8 @@ void FSavedMove_SampleCharacter::Clear()
     Super::Clear();
 
     ClimbTimer = 0.0f;
+    ClimbGrabTimer = 0.0f;
+    ClimbCoyoteTimer = 0.0f;
     bWantsToClimb = false;
 }
 
@@ -235,6 +456,8 @@ void FSavedMove_SampleCharacter::SetMoveFor(ACharacter* Character, float InDelta
     USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetMovementComponent());
 
     ClimbTimer = MoveComponent->ClimbTimer;
+    ClimbGrabTimer = MoveComponent->ClimbGrabTimer;
+    ClimbCoyoteTimer = MoveComponent->ClimbCoyoteTimer;
     bWantsToClimb = MoveComponent->bWantsToClimb;
 
     Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
@@ -247,6 +470,8 @@ void FSavedMove_SampleCharacter::PrepMoveFor(ACharacter* Character)
     if (MoveComponent)
     {
         MoveComponent->ClimbTimer = ClimbTimer;
+        MoveComponent->ClimbGrabTimer = ClimbGrabTimer;
+        MoveComponent->ClimbCoyoteTimer = ClimbCoyoteTimer;
         MoveComponent->bWantsToClimb = bWantsToClimb;
     }
 
@@ -262,12 +487,17 @@ uint8 FSavedMove_SampleCharacter::GetCompressedFlags() const
         Result |= FLAG_ClimbPressed;
     }
 
+    if (ClimbGrabTimer > 0.0f)
+    {
+        Result |= FLAG_ClimbBuffered;
+    }
+
     return Result;
 }
 
 bool FSavedMove_SampleCharacter::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const
 {
-    const FSavedMove_SampleCharacter* SampleNewMove = (FSavedMove_SampleCharacter*)&NewMove;
+    const FSavedMove_SampleCharacter* SampleNewMove = static_cast<const FSavedMove_SampleCharacter*>(NewMove.Get());
 
     if (!FMath::IsNearlyEqual(ClimbTimer, SampleNewMove->ClimbTimer, ClimbTimerThresholdCombine))
     {
@@ -284,27 +514,45 @@ bool FSavedMove_SampleCharacter::CanCombineWith(const FSavedMovePtr& NewMove, AC
         return false;
     }
 
+    // Don't combine across the start or the end of a buffered press or a coyote time
+    if ((ClimbGrabTimer > 0.0f) != (SampleNewMove->ClimbGrabTimer > 0.0f))
+    {
+        return false;
+    }
+
+    if ((ClimbCoyoteTimer > 0.0f) != (SampleNewMove->ClimbCoyoteTimer > 0.0f))
+    {
+        return false;
+    }
+
     return Super::CanCombineWith(NewMove, Character, MaxDelta);
 }
 
 void FSavedMove_SampleCharacter::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
 {
-    const FSavedMove_SampleCharacter* SampleNewMove = (FSavedMove_SampleCharacter*)&OldMove;
+    const FSavedMove_SampleCharacter* SampleNewMove = static_cast<const FSavedMove_SampleCharacter*>(OldMove);
 
     ClimbTimer = SampleNewMove->ClimbTimer;
+    ClimbGrabTimer = SampleNewMove->ClimbGrabTimer;
+    ClimbCoyoteTimer = SampleNewMove->ClimbCoyoteTimer;
 
     Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
 }
 
 bool FSavedMove_SampleCharacter::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
 {
-    const FSavedMove_SampleCharacter* SampleLastAckedMove = (FSavedMove_SampleCharacter*)&LastAckedMove;
+    const FSavedMove_SampleCharacter* SampleLastAckedMove = static_cast<const FSavedMove_SampleCharacter*>(LastAckedMove.Get());
 
     if (!FMath::IsNearlyEqual(ClimbTimer, SampleLastAckedMove->ClimbTimer, ClimbTimerThresholdCombine))
     {
         return true;
     }
 
+    if ((ClimbGrabTimer > 0.0f) != (SampleLastAckedMove->ClimbGrabTimer > 0.0f))
+    {
+        return true;
+    }
+
     return Super::IsImportantMove(LastAckedMove);
 }
 
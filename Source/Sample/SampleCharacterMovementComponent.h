@@ -1,8 +1,11 @@
 #pragma once
 
 #include "GameFramework/CharacterMovementComponent.h"
+#include "SampleProxySmoothing.h"
 #include "SampleCharacterMovementComponent.generated.h"
 
+struct FSampleCharacterMemory;
+
 enum class ESampleMovementMode : uint8
 {
     MOVE_None = 0,
@@ -21,7 +24,7 @@ public:
     virtual float GetMaxSpeed() const override;
     /** Specify max braking deceleration when climbing */
     virtual float GetMaxBrakingDeceleration() const;
-    /** Allow to jump when climbing */
+    /** Allow to jump when climbing or shortly after leaving a wall */
     virtual bool CanAttemptJump() const override;
     virtual bool DoJump(bool bReplayingMoves) override;
     /** Apply bWantsToClimb before movement */
@@ -31,6 +34,10 @@ public:
     virtual bool CanClimbInCurrentState() const;
     /** If we are in the MOVE_Climbing movement mode */
     virtual bool IsClimbing() const;
+    /** If we left a wall without jumping less than ClimbCoyoteTime ago */
+    virtual bool IsInClimbCoyoteTime() const;
+    /** Buffer a Climb press for ClimbGrabWindow so a wall reached shortly after is still grabbed */
+    virtual void BufferClimbInput();
     /** Change movement mode to MOVE_Climbing */
     virtual void Climb(bool bClientSimulation);
     /** Change movement mode to MOVE_Falling */
@@ -41,6 +48,11 @@ public:
     /** Custom prediction data sent to client */
     virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
     virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+    /** Add the memory used by the client and server prediction data, without allocating them */
+    void GatherPredictionMemoryUsage(FSampleCharacterMemory& OutMemory) const;
+    virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+    /** Record replicated updates of simulated proxies for the climb-aware smoothing */
+    virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
 
     /** If true, try to climb (or keep climbing) on next update. If false, try to stop climbing on next update. */
     UPROPERTY(Category = "Sample", VisibleInstanceOnly, BlueprintReadOnly)
@@ -70,6 +82,60 @@ public:
     /** If true, try to climb (or keep climbing) on next update. If false, try to stop climbing on next update. */
     UPROPERTY(Category = "Sample", VisibleInstanceOnly, BlueprintReadOnly)
     bool bWantsToClimb;
+
+    /**
+     * Time during which a Climb press is remembered, so pressing slightly before reaching
+     * a wall (or before ClimbTimer ends) still grabs it. The wall is then held until Climb
+     * is released again, even if it was already released before the grab.
+     */
+    UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+    float ClimbGrabWindow;
+
+    /** Time during which the character can still jump as if climbing after leaving a wall without jumping. */
+    UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+    float ClimbCoyoteTime;
+
+    /** Remaining time before a buffered Climb press is dropped. */
+    UPROPERTY(Category = "Sample", VisibleInstanceOnly, BlueprintReadOnly)
+    float ClimbGrabTimer;
+
+    /** Remaining time during which the character can jump as if climbing. */
+    UPROPERTY(Category = "Sample", VisibleInstanceOnly, BlueprintReadOnly)
+    float ClimbCoyoteTimer;
+
+    /**
+     * If true, simulated proxies are drawn from a history of replicated updates, interpolating
+     * along the wall plane and extrapolating across climb transitions.
+     */
+    UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, BlueprintReadWrite)
+    bool bUseClimbSmoothing;
+
+    /** How far in the past simulated proxies are drawn when using the climb smoothing. */
+    UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0", EditCondition = "bUseClimbSmoothing"))
+    float ClimbSmoothingDelay;
+
+    /** Maximum time simulated proxies are extrapolated when no update is received. */
+    UPROPERTY(Category = "Character Movement: Climbing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0", EditCondition = "bUseClimbSmoothing"))
+    float ClimbSmoothingMaxExtrapolation;
+
+protected:
+    virtual void SmoothClientPosition(float DeltaSeconds) override;
+
+private:
+    /** Start measuring the latency between a Climb input and MOVE_Climbing */
+    void StartClimbLatencyMeasure();
+    /** Report the latency of the pending Climb input now that MOVE_Climbing is active */
+    void StopClimbLatencyMeasure();
+
+    /** If a Climb input is waiting for MOVE_Climbing to be measured */
+    bool bClimbLatencyPending;
+    /** Frame at which the measured Climb input happened */
+    uint64 ClimbLatencyStartFrame;
+    /** Time at which the measured Climb input happened */
+    double ClimbLatencyStartTime;
+
+    /** Replicated updates of a simulated proxy */
+    FSampleProxySmoothing ProxySmoothing;
 };
 
 // Custom FSavedMove_Character used to save custom inputs.
@@ -82,6 +148,8 @@ public:
     virtual ~FSavedMove_SampleCharacter();
 
     float ClimbTimer;
+    float ClimbGrabTimer;
+    float ClimbCoyoteTimer;
     uint32 bWantsToClimb : 1;
     float ClimbTimerThresholdCombine;
 
@@ -95,7 +163,8 @@ public:
 
     enum CustomCompressedFlags : uint8
     {
-        FLAG_ClimbPressed = 0x10
+        FLAG_ClimbPressed = 0x10,
+        FLAG_ClimbBuffered = 0x20
     };
 };
 
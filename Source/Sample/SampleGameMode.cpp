@@ -3,9 +3,36 @@
 #include "SampleGameMode.h"
 #include "SampleCharacter.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
 
 ASampleGameMode::ASampleGameMode()
 {
 	// Set default pawn class to our character
 	DefaultPawnClass = ASampleCharacter::StaticClass();	
-}
\ No newline at end of file
+}
+
+void ASampleGameMode::SpawnSampleCharacters(int32 Count, float Width, float Height)
+{
+	UWorld* World = GetWorld();
+	APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!World || !DefaultPawnClass || Count <= 0)
+	{
+		return;
+	}
+
+	const FVector Origin = PlayerPawn ? PlayerPawn->GetActorLocation() : FVector::ZeroVector;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Use a fixed seed so profiling sessions are comparable
+	FRandomStream Random(Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location = Origin + FVector(Random.FRandRange(-0.5f, 0.5f) * Width, 0.0f, Random.FRand() * Height);
+		if (APawn* Pawn = World->SpawnActor<APawn>(DefaultPawnClass, Location, FRotator::ZeroRotator, SpawnParams))
+		{
+			Pawn->SpawnDefaultController();
+		}
+	}
+}
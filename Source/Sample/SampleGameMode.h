@@ -18,4 +18,8 @@ class ASampleGameMode : public AGameModeBase
 	GENERATED_BODY()
 public:
 	ASampleGameMode();
+
+	/** Debug command spawning Count characters spread over a Width x Height area above the first player, used to profile large crowds */
+	UFUNCTION(Exec)
+	void SpawnSampleCharacters(int32 Count, float Width = 512.0f, float Height = 4096.0f);
 };
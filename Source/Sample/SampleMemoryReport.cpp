@@ -0,0 +1,363 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleMemoryReport.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleTrainingEnvironment.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarSampleMemReportBudget(
+	TEXT("Sample.MemReport.BudgetBytes"),
+	0,
+	TEXT("Bytes allowed per character, Sample.MemReport warns about roles above it. 0 to disable."),
+	ECVF_Default);
+
+void FSampleCharacterMemory::Accumulate(const FSampleCharacterMemory& Other)
+{
+	for (int32 Index = 0; Index < (int32)ESampleMemoryCategory::Num; ++Index)
+	{
+		Bytes[Index] += Other.Bytes[Index];
+		Allocations[Index] += Other.Allocations[Index];
+	}
+}
+
+int64 FSampleCharacterMemory::GetTotalBytes() const
+{
+	int64 Total = 0;
+	for (int64 CategoryBytes : Bytes)
+	{
+		Total += CategoryBytes;
+	}
+	return Total;
+}
+
+int32 FSampleCharacterMemory::GetTotalAllocations() const
+{
+	int32 Total = 0;
+	for (int32 CategoryAllocations : Allocations)
+	{
+		Total += CategoryAllocations;
+	}
+	return Total;
+}
+
+const TCHAR* FSampleCharacterMemory::GetCategoryName(ESampleMemoryCategory Category)
+{
+	switch (Category)
+	{
+	case ESampleMemoryCategory::Actor: return TEXT("Actor");
+	case ESampleMemoryCategory::ClientPrediction: return TEXT("ClientPrediction");
+	case ESampleMemoryCategory::SavedMoves: return TEXT("SavedMoves");
+	case ESampleMemoryCategory::ServerPrediction: return TEXT("ServerPrediction");
+	case ESampleMemoryCategory::Volumes: return TEXT("Volumes");
+	case ESampleMemoryCategory::Sprite: return TEXT("Sprite");
+	case ESampleMemoryCategory::Camera: return TEXT("Camera");
+	case ESampleMemoryCategory::OtherComponents: return TEXT("OtherComponents");
+	default: return TEXT("Unknown");
+	}
+}
+
+static FString GetRoleName(int32 Role)
+{
+	return StaticEnum<ENetRole>()->GetNameStringByValue(Role);
+}
+
+void USampleMemoryReportSubsystem::Capture(TArray<FSampleRoleMemory>& OutRoles) const
+{
+	OutRoles.Reset();
+	OutRoles.SetNum(ROLE_MAX);
+
+	for (TActorIterator<ASampleCharacter> It(GetWorld()); It; ++It)
+	{
+		FSampleCharacterMemory Memory;
+		It->GatherMemoryUsage(Memory);
+
+		FSampleRoleMemory& Role = OutRoles[It->GetLocalRole()];
+		++Role.NumCharacters;
+		Role.Total.Accumulate(Memory);
+	}
+}
+
+void USampleMemoryReportSubsystem::LogReport() const
+{
+	TArray<FSampleRoleMemory> Roles;
+	Capture(Roles);
+
+	const int64 Budget = CVarSampleMemReportBudget.GetValueOnGameThread();
+	for (int32 RoleIndex = 0; RoleIndex < Roles.Num(); ++RoleIndex)
+	{
+		const FSampleRoleMemory& Role = Roles[RoleIndex];
+		if (Role.NumCharacters == 0)
+		{
+			continue;
+		}
+
+		const int64 BytesPerCharacter = Role.Total.GetTotalBytes() / Role.NumCharacters;
+		UE_LOG(LogSample, Display, TEXT("%s: %d characters, %lld bytes and %d allocations per character (%lld bytes total)"),
+			*GetRoleName(RoleIndex), Role.NumCharacters, BytesPerCharacter, Role.Total.GetTotalAllocations() / Role.NumCharacters, Role.Total.GetTotalBytes());
+
+		for (int32 Category = 0; Category < (int32)ESampleMemoryCategory::Num; ++Category)
+		{
+			UE_LOG(LogSample, Display, TEXT("    %-18s %8lld bytes %4d allocations"),
+				FSampleCharacterMemory::GetCategoryName((ESampleMemoryCategory)Category),
+				Role.Total.Bytes[Category] / Role.NumCharacters, Role.Total.Allocations[Category] / Role.NumCharacters);
+		}
+
+		if (Budget > 0 && BytesPerCharacter > Budget)
+		{
+			UE_LOG(LogSample, Warning, TEXT("%s characters use %lld bytes, above the budget of %lld bytes"), *GetRoleName(RoleIndex), BytesPerCharacter, Budget);
+		}
+	}
+}
+
+void USampleMemoryReportSubsystem::StartSoak(float Interval)
+{
+	StopSoak();
+
+	if (Interval <= 0.0f)
+	{
+		return;
+	}
+
+	SoakInterval = Interval;
+	SoakAccumulator = 0.0f;
+	SoakStartTime = FPlatformTime::Seconds();
+	SoakBaseline.Reset();
+	SoakFilename = FPaths::ProfilingDir() / FString::Printf(TEXT("SampleMemReport-%s.csv"), *FDateTime::Now().ToString());
+
+	FString Header = TEXT("Time,Role,Characters,BytesPerCharacter,AllocationsPerCharacter");
+	for (int32 Category = 0; Category < (int32)ESampleMemoryCategory::Num; ++Category)
+	{
+		Header += FString::Printf(TEXT(",%s"), FSampleCharacterMemory::GetCategoryName((ESampleMemoryCategory)Category));
+	}
+	FFileHelper::SaveStringToFile(Header + LINE_TERMINATOR, *SoakFilename);
+
+	UE_LOG(LogSample, Display, TEXT("Memory soak started, writing to %s every %.1f s"), *SoakFilename, SoakInterval);
+	WriteSoakSample();
+}
+
+void USampleMemoryReportSubsystem::StopSoak()
+{
+	if (SoakInterval <= 0.0f)
+	{
+		return;
+	}
+
+	WriteSoakSample();
+	SoakInterval = 0.0f;
+
+	// Growth of each role since the soak started
+	TArray<FSampleRoleMemory> Roles;
+	Capture(Roles);
+	for (int32 RoleIndex = 0; RoleIndex < Roles.Num() && RoleIndex < SoakBaseline.Num(); ++RoleIndex)
+	{
+		if (Roles[RoleIndex].NumCharacters > 0 && SoakBaseline[RoleIndex] > 0)
+		{
+			const int64 BytesPerCharacter = Roles[RoleIndex].Total.GetTotalBytes() / Roles[RoleIndex].NumCharacters;
+			UE_LOG(LogSample, Display, TEXT("%s: %lld -> %lld bytes per character over %.0f s"),
+				*GetRoleName(RoleIndex), SoakBaseline[RoleIndex], BytesPerCharacter, FPlatformTime::Seconds() - SoakStartTime);
+		}
+	}
+
+	UE_LOG(LogSample, Display, TEXT("Memory soak stopped, results in %s"), *SoakFilename);
+}
+
+void USampleMemoryReportSubsystem::WriteSoakSample()
+{
+	TArray<FSampleRoleMemory> Roles;
+	Capture(Roles);
+
+	const bool bFirstSample = SoakBaseline.Num() == 0;
+	if (bFirstSample)
+	{
+		SoakBaseline.SetNumZeroed(Roles.Num());
+	}
+
+	const double Time = FPlatformTime::Seconds() - SoakStartTime;
+	FString Lines;
+	for (int32 RoleIndex = 0; RoleIndex < Roles.Num(); ++RoleIndex)
+	{
+		const FSampleRoleMemory& Role = Roles[RoleIndex];
+		if (Role.NumCharacters == 0)
+		{
+			continue;
+		}
+
+		const int64 BytesPerCharacter = Role.Total.GetTotalBytes() / Role.NumCharacters;
+		if (SoakBaseline[RoleIndex] == 0)
+		{
+			SoakBaseline[RoleIndex] = BytesPerCharacter;
+		}
+
+		Lines += FString::Printf(TEXT("%.1f,%s,%d,%lld,%d"), Time, *GetRoleName(RoleIndex), Role.NumCharacters, BytesPerCharacter, Role.Total.GetTotalAllocations() / Role.NumCharacters);
+		for (int32 Category = 0; Category < (int32)ESampleMemoryCategory::Num; ++Category)
+		{
+			Lines += FString::Printf(TEXT(",%lld"), Role.Total.Bytes[Category] / Role.NumCharacters);
+		}
+		Lines += LINE_TERMINATOR;
+	}
+
+	FFileHelper::SaveStringToFile(Lines, *SoakFilename, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+void USampleMemoryReportSubsystem::Deinitialize()
+{
+	StopSoak();
+
+	Super::Deinitialize();
+}
+
+void USampleMemoryReportSubsystem::Tick(float DeltaTime)
+{
+	if (SoakInterval <= 0.0f)
+	{
+		return;
+	}
+
+	SoakAccumulator += DeltaTime;
+	if (SoakAccumulator >= SoakInterval)
+	{
+		SoakAccumulator = 0.0f;
+		WriteSoakSample();
+	}
+}
+
+TStatId USampleMemoryReportSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USampleMemoryReportSubsystem, STATGROUP_Tickables);
+}
+
+bool USampleMemoryReportSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console commands
+
+static FAutoConsoleCommandWithWorld SampleMemReportCommand(
+	TEXT("Sample.MemReport"),
+	TEXT("Log the memory used by each character, by network role."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (USampleMemoryReportSubsystem* MemoryReport = World ? World->GetSubsystem<USampleMemoryReportSubsystem>() : nullptr)
+		{
+			MemoryReport->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SampleMemReportSoakCommand(
+	TEXT("Sample.MemReport.Soak"),
+	TEXT("Capture the memory used by characters to a CSV every Interval seconds. Usage: Sample.MemReport.Soak [Interval], 0 to stop"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USampleMemoryReportSubsystem* MemoryReport = World ? World->GetSubsystem<USampleMemoryReportSubsystem>() : nullptr)
+		{
+			MemoryReport->StartSoak(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 60.0f);
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// Automation
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSampleMemoryReportTest, "Sample.MemoryReport",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSampleMemoryReportTest::RunTest(const FString& Parameters)
+{
+	// Report the running game when there is one, so every role of a network session is covered
+	UWorld* World = nullptr;
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World()
+			&& TActorIterator<ASampleCharacter>(Context.World()))
+		{
+			World = Context.World();
+			break;
+		}
+	}
+
+	// Otherwise a headless world with a single authority character
+	USampleTrainingEnvironment* Environment = nullptr;
+	if (!World)
+	{
+		Environment = NewObject<USampleTrainingEnvironment>();
+		Environment->AddToRoot();
+		Environment->CreateWorlds(1, ASampleCharacter::StaticClass(), FSampleTrainingLayout::MakeDefault());
+		World = Environment->GetTrainingWorld(0);
+	}
+
+	const USampleMemoryReportSubsystem* MemoryReport = World->GetSubsystem<USampleMemoryReportSubsystem>();
+	if (TestNotNull(TEXT("Memory report subsystem"), MemoryReport))
+	{
+		TArray<FSampleRoleMemory> Roles;
+		MemoryReport->Capture(Roles);
+
+		int32 NumCharacters = 0;
+		for (TActorIterator<ASampleCharacter> It(World); It; ++It)
+		{
+			++NumCharacters;
+		}
+
+		int32 NumCapturedCharacters = 0;
+		const int64 Budget = CVarSampleMemReportBudget.GetValueOnGameThread();
+		for (int32 RoleIndex = 0; RoleIndex < Roles.Num(); ++RoleIndex)
+		{
+			const FSampleRoleMemory& Role = Roles[RoleIndex];
+			NumCapturedCharacters += Role.NumCharacters;
+			if (Role.NumCharacters == 0)
+			{
+				TestEqual(FString::Printf(TEXT("%s bytes without characters"), *GetRoleName(RoleIndex)), Role.Total.GetTotalBytes(), (int64)0);
+				continue;
+			}
+
+			for (int32 Category = 0; Category < (int32)ESampleMemoryCategory::Num; ++Category)
+			{
+				const FString What = FString::Printf(TEXT("%s %s"), *GetRoleName(RoleIndex), FSampleCharacterMemory::GetCategoryName((ESampleMemoryCategory)Category));
+				const int64 Bytes = Role.Total.Bytes[Category];
+				const int32 Allocations = Role.Total.Allocations[Category];
+				TestTrue(What + TEXT(" bytes and allocations are not negative"), Bytes >= 0 && Allocations >= 0);
+				TestTrue(What + TEXT(" allocations have bytes"), Allocations == 0 || Bytes > 0);
+			}
+
+			// Every character has an actor and these components
+			for (ESampleMemoryCategory Category : { ESampleMemoryCategory::Actor, ESampleMemoryCategory::Sprite, ESampleMemoryCategory::Camera, ESampleMemoryCategory::OtherComponents })
+			{
+				const FString What = FString::Printf(TEXT("%s %s"), *GetRoleName(RoleIndex), FSampleCharacterMemory::GetCategoryName(Category));
+				TestTrue(What + TEXT(" bytes"), Role.Total.Bytes[(int32)Category] > 0);
+				TestTrue(What + TEXT(" allocations"), Role.Total.Allocations[(int32)Category] >= Role.NumCharacters);
+			}
+
+			const int64 BytesPerCharacter = Role.Total.GetTotalBytes() / Role.NumCharacters;
+			AddInfo(FString::Printf(TEXT("%s: %d characters, %lld bytes and %d allocations per character"),
+				*GetRoleName(RoleIndex), Role.NumCharacters, BytesPerCharacter, Role.Total.GetTotalAllocations() / Role.NumCharacters));
+
+			if (Budget > 0 && BytesPerCharacter > Budget)
+			{
+				AddError(FString::Printf(TEXT("%s characters use %lld bytes, above the budget of %lld bytes set by Sample.MemReport.BudgetBytes"),
+					*GetRoleName(RoleIndex), BytesPerCharacter, Budget));
+			}
+		}
+
+		TestEqual(TEXT("Captured characters"), NumCapturedCharacters, NumCharacters);
+	}
+
+	if (Environment)
+	{
+		Environment->DestroyWorlds();
+		Environment->RemoveFromRoot();
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
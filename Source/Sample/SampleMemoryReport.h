@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SampleMemoryReport.generated.h"
+
+/** Parts of a character tracked by the memory report */
+enum class ESampleMemoryCategory : uint8
+{
+	/** The actor and its properties */
+	Actor,
+	/** FNetworkPredictionData_Client_SampleCharacter and its move arrays */
+	ClientPrediction,
+	/** Pool of FSavedMove_SampleCharacter */
+	SavedMoves,
+	/** FNetworkPredictionData_Server_Character */
+	ServerPrediction,
+	/** The transient set of overlapping climbable volumes */
+	Volumes,
+	/** The flipbook component */
+	Sprite,
+	/** The side view camera component */
+	Camera,
+	/** Capsule, movement and other components */
+	OtherComponents,
+	Num
+};
+
+/**
+ * Memory used by one character. Bytes include the allocated size of containers,
+ * allocations are an estimate of the number of heap blocks.
+ */
+struct SAMPLE_API FSampleCharacterMemory
+{
+	int64 Bytes[(int32)ESampleMemoryCategory::Num] = {};
+	int32 Allocations[(int32)ESampleMemoryCategory::Num] = {};
+
+	void Add(ESampleMemoryCategory Category, int64 InBytes, int32 InAllocations)
+	{
+		Bytes[(int32)Category] += InBytes;
+		Allocations[(int32)Category] += InAllocations;
+	}
+
+	void Accumulate(const FSampleCharacterMemory& Other);
+	int64 GetTotalBytes() const;
+	int32 GetTotalAllocations() const;
+
+	static const TCHAR* GetCategoryName(ESampleMemoryCategory Category);
+};
+
+/** Memory used by all characters of a network role */
+struct SAMPLE_API FSampleRoleMemory
+{
+	int32 NumCharacters = 0;
+	FSampleCharacterMemory Total;
+};
+
+/**
+ * Breaks down the memory used by each ASampleCharacter by network role, on demand with
+ * Sample.MemReport or periodically during a soak session with Sample.MemReport.Soak, which
+ * writes a CSV to Saved/Profiling to track growth over time. The Sample.MemoryReport automation
+ * test checks a capture and fails above the budget.
+ */
+UCLASS()
+class USampleMemoryReportSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Measure every character of the world, indexed by ENetRole */
+	void Capture(TArray<FSampleRoleMemory>& OutRoles) const;
+
+	/** Log a capture, and warn about roles above Sample.MemReport.BudgetBytes per character */
+	void LogReport() const;
+
+	/** Capture every Interval seconds to a CSV file */
+	void StartSoak(float Interval);
+	void StopSoak();
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void WriteSoakSample();
+
+	/** Time between two soak captures, 0 when not soaking */
+	float SoakInterval = 0.0f;
+	float SoakAccumulator = 0.0f;
+	double SoakStartTime = 0.0;
+	FString SoakFilename;
+
+	/** Bytes per character of each role at the first soak capture, to log the growth */
+	TArray<int64> SoakBaseline;
+};
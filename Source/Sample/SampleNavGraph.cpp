@@ -0,0 +1,386 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleNavGraph.h"
+#include "Sample.h"
+#include "SampleClimbableVolume.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Algo/Reverse.h"
+
+/** Above this number of cells the bounds or the cell size are probably wrong */
+static const int64 SampleNavMaxCells = 4 * 1024 * 1024;
+
+/** How far FindNearestNode looks around the cell of the location */
+static const int32 SampleNavNearestNodeRadius = 4;
+
+TSharedRef<FSampleNavGraph, ESPMode::ThreadSafe> FSampleNavGraph::Build(UWorld* World, const FSampleNavBuildParams& InParams)
+{
+	TSharedRef<FSampleNavGraph, ESPMode::ThreadSafe> Graph = MakeShared<FSampleNavGraph, ESPMode::ThreadSafe>();
+	Graph->Params = InParams;
+
+	const FSampleNavBuildParams& Params = Graph->Params;
+	if (!World || !Params.Bounds.bIsValid || Params.CellSize <= 0.0f || Params.Gravity <= 0.0f || Params.MaxWalkSpeed <= 0.0f)
+	{
+		return Graph;
+	}
+
+	const FVector2D BoundsSize = Params.Bounds.GetSize();
+	const int32 SizeX = FMath::Max(1, FMath::CeilToInt(BoundsSize.X / Params.CellSize));
+	const int32 SizeZ = FMath::Max(1, FMath::CeilToInt(BoundsSize.Y / Params.CellSize));
+	if ((int64)SizeX * SizeZ > SampleNavMaxCells)
+	{
+		UE_LOG(LogSample, Warning, TEXT("Navigation graph of %dx%d cells is too large, increase the cell size"), SizeX, SizeZ);
+		return Graph;
+	}
+
+	Graph->SizeX = SizeX;
+	Graph->SizeZ = SizeZ;
+	Graph->CellNodes.Init(INDEX_NONE, SizeX * SizeZ);
+
+	// No link moves faster than the character can: walking horizontally while falling from the top
+	// of the bounds, or jumping down from it, so the heuristic never overestimates
+	const float MaxAirSpeed = FMath::Sqrt(FMath::Square(Params.MaxWalkSpeed) + FMath::Square(Params.JumpZVelocity) + 2.0f * Params.Gravity * BoundsSize.Y);
+	Graph->InvMaxSpeed = 1.0f / FMath::Max3(Params.MaxWalkSpeed, Params.MaxClimbSpeed, MaxAirSpeed);
+
+	// The character can climb as soon as its capsule overlaps a volume
+	TArray<FBox> ClimbableBoxes;
+	for (TActorIterator<ASampleClimbableVolume> It(World); It; ++It)
+	{
+		if (const UBoxComponent* Box = It->GetBoxComponent())
+		{
+			ClimbableBoxes.Add(Box->Bounds.GetBox().ExpandBy(FVector(Params.CapsuleRadius, 0.0f, Params.CapsuleHalfHeight)));
+		}
+	}
+
+	// Only the level geometry blocks, climbable volumes and pawns are ignored
+	const FCollisionShape CapsuleShape = FCollisionShape::MakeCapsule(Params.CapsuleRadius, Params.CapsuleHalfHeight);
+	const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SampleNavBuild), false);
+
+	auto GetCellLocation = [&Params](int32 X, int32 Z)
+	{
+		return Params.Bounds.Min + FVector2D(X + 0.5f, Z + 0.5f) * Params.CellSize;
+	};
+
+	// Find free cells, and create a node for each one the character can stand or climb in
+	TBitArray<> FreeCells(false, SizeX * SizeZ);
+	for (int32 Z = 0; Z < SizeZ; ++Z)
+	{
+		for (int32 X = 0; X < SizeX; ++X)
+		{
+			const FVector2D Location = GetCellLocation(X, Z);
+			const FVector WorldLocation(Location.X, Params.PlaneY, Location.Y);
+			if (World->OverlapAnyTestByObjectType(WorldLocation, FQuat::Identity, ObjectParams, CapsuleShape, QueryParams))
+			{
+				continue;
+			}
+
+			FreeCells[Z * SizeX + X] = true;
+
+			const bool bWalkable = World->SweepTestByObjectType(WorldLocation, WorldLocation - FVector(0.0f, 0.0f, Params.CellSize * 0.5f), FQuat::Identity, ObjectParams, CapsuleShape, QueryParams);
+			const bool bClimbable = ClimbableBoxes.ContainsByPredicate([&WorldLocation](const FBox& Box)
+			{
+				return WorldLocation.X >= Box.Min.X && WorldLocation.X <= Box.Max.X && WorldLocation.Z >= Box.Min.Z && WorldLocation.Z <= Box.Max.Z;
+			});
+
+			if (bWalkable || bClimbable)
+			{
+				Graph->CellNodes[Z * SizeX + X] = Graph->Nodes.Num();
+
+				FSampleNavNode& Node = Graph->Nodes.AddDefaulted_GetRef();
+				Node.Location = Location;
+				Node.FirstLink = 0;
+				Node.NumLinks = 0;
+				Node.bWalkable = bWalkable;
+				Node.bClimbable = bClimbable;
+			}
+		}
+	}
+
+	auto IsFree = [&](int32 X, int32 Z)
+	{
+		return X >= 0 && X < SizeX && Z >= 0 && Z < SizeZ && FreeCells[Z * SizeX + X];
+	};
+
+	// Keep a single link, the fastest, between two nodes
+	auto AddLink = [&Graph](const FSampleNavNode& Node, int32 Target, float Cost, ESampleNavLinkType Type)
+	{
+		for (int32 Index = Node.FirstLink; Index < Graph->Links.Num(); ++Index)
+		{
+			FSampleNavLink& Link = Graph->Links[Index];
+			if (Link.Target == Target)
+			{
+				if (Cost < Link.Cost)
+				{
+					Link.Cost = Cost;
+					Link.Type = Type;
+				}
+				return;
+			}
+		}
+
+		Graph->Links.Add({ Target, Cost, Type });
+	};
+
+	// Check the cells crossed by a jump of Duration seconds
+	const float Gravity = Params.Gravity;
+	const float JumpVelocity = Params.JumpZVelocity;
+	auto IsJumpClear = [&](const FVector2D& From, const FVector2D& Delta, float Duration)
+	{
+		const int32 Steps = FMath::Max(2, FMath::CeilToInt(FMath::Max(FMath::Abs(Delta.X), FMath::Abs(Delta.Y) + JumpVelocity * Duration) / (Params.CellSize * 0.5f)));
+		for (int32 Step = 1; Step < Steps; ++Step)
+		{
+			const float Alpha = (float)Step / Steps;
+			const float Time = Duration * Alpha;
+			const FVector2D Point = From + FVector2D(Delta.X * Alpha, JumpVelocity * Time - 0.5f * Gravity * Time * Time) - Params.Bounds.Min;
+			if (!IsFree(FMath::FloorToInt(Point.X / Params.CellSize), FMath::FloorToInt(Point.Y / Params.CellSize)))
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Maximum jump height and horizontal reach, in cells
+	const float JumpHeight = (JumpVelocity * JumpVelocity) / (2.0f * Gravity);
+	const int32 JumpCellsZ = FMath::FloorToInt(JumpHeight / Params.CellSize);
+	const bool bCanClimb = Params.MaxClimbSpeed > 0.0f;
+	const int32 JumpCellsX = FMath::CeilToInt(Params.MaxWalkSpeed * (2.0f * JumpVelocity / Gravity) / Params.CellSize);
+
+	for (int32 Z = 0; Z < SizeZ; ++Z)
+	{
+		for (int32 X = 0; X < SizeX; ++X)
+		{
+			const int32 NodeIndex = Graph->CellNodes[Z * SizeX + X];
+			if (NodeIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			FSampleNavNode& Node = Graph->Nodes[NodeIndex];
+			Node.FirstLink = Graph->Links.Num();
+
+			// Walk, step up or down, climb and grab or leave a wall
+			for (int32 DZ = -1; DZ <= 1; ++DZ)
+			{
+				for (int32 DX = -1; DX <= 1; ++DX)
+				{
+					const int32 Target = Graph->GetCellNode(X + DX, Z + DZ);
+					if (Target == INDEX_NONE || Target == NodeIndex)
+					{
+						continue;
+					}
+
+					const FSampleNavNode& TargetNode = Graph->Nodes[Target];
+					const float Distance = FVector2D::Distance(Node.Location, TargetNode.Location);
+					if (Node.bWalkable && TargetNode.bWalkable && DX != 0)
+					{
+						AddLink(Node, Target, Distance / Params.MaxWalkSpeed, ESampleNavLinkType::Walk);
+					}
+					if (bCanClimb && (Node.bClimbable || TargetNode.bClimbable) && (Node.bClimbable || DX == 0 || DZ == 0))
+					{
+						AddLink(Node, Target, Distance / Params.MaxClimbSpeed, ESampleNavLinkType::Climb);
+					}
+				}
+			}
+
+			// Walk off a ledge, or let go of a wall, and land on the first ground below
+			for (int32 DX = -1; DX <= 1; ++DX)
+			{
+				if ((DX == 0 && !Node.bClimbable) || !IsFree(X + DX, Z))
+				{
+					continue;
+				}
+
+				for (int32 FallZ = Z - 1; IsFree(X + DX, FallZ); --FallZ)
+				{
+					const int32 Target = Graph->GetCellNode(X + DX, FallZ);
+					if (Target != INDEX_NONE && Graph->Nodes[Target].bWalkable)
+					{
+						const float Height = (Z - FallZ) * Params.CellSize;
+						AddLink(Node, Target, FMath::Sqrt(2.0f * Height / Gravity) + FMath::Abs(DX) * Params.CellSize / Params.MaxWalkSpeed, ESampleNavLinkType::Fall);
+						break;
+					}
+				}
+			}
+
+			// Jump to the highest reachable ground and wall of each column in range
+			for (int32 DX = -JumpCellsX; DX <= JumpCellsX; ++DX)
+			{
+				bool bFoundWalkable = false;
+				bool bFoundClimbable = false;
+				for (int32 DZ = JumpCellsZ; DZ >= -JumpCellsZ && !(bFoundWalkable && bFoundClimbable); --DZ)
+				{
+					if (FMath::Abs(DX) <= 1 && FMath::Abs(DZ) <= 1)
+					{
+						continue;
+					}
+
+					const int32 Target = Graph->GetCellNode(X + DX, Z + DZ);
+					if (Target == INDEX_NONE)
+					{
+						continue;
+					}
+
+					const FSampleNavNode& TargetNode = Graph->Nodes[Target];
+					const FVector2D Delta = TargetNode.Location - Node.Location;
+					const float Discriminant = JumpVelocity * JumpVelocity - 2.0f * Gravity * Delta.Y;
+					if (Discriminant < 0.0f)
+					{
+						continue;
+					}
+
+					// The target height is crossed while going up then while going down
+					const float RisingTime = (JumpVelocity - FMath::Sqrt(Discriminant)) / Gravity;
+					const float FallingTime = (JumpVelocity + FMath::Sqrt(Discriminant)) / Gravity;
+					const float MinTime = FMath::Abs(Delta.X) / Params.MaxWalkSpeed;
+
+					// Ground can only be reached while falling
+					if (!bFoundWalkable && TargetNode.bWalkable && MinTime <= FallingTime && IsJumpClear(Node.Location, Delta, FallingTime))
+					{
+						AddLink(Node, Target, FallingTime, ESampleNavLinkType::Jump);
+						bFoundWalkable = true;
+					}
+
+					// A wall can be grabbed at any time, but not before ClimbCooldown when jumping off a wall
+					if (!bFoundClimbable && TargetNode.bClimbable)
+					{
+						const float GrabTime = FMath::Max3(RisingTime, MinTime, Node.bClimbable ? Params.ClimbCooldown : 0.0f);
+						if (GrabTime <= FallingTime && IsJumpClear(Node.Location, Delta, GrabTime))
+						{
+							AddLink(Node, Target, GrabTime, ESampleNavLinkType::Jump);
+							bFoundClimbable = true;
+						}
+					}
+				}
+			}
+
+			Node.NumLinks = Graph->Links.Num() - Node.FirstLink;
+		}
+	}
+
+	Graph->Links.Shrink();
+
+	UE_LOG(LogSample, Log, TEXT("Built navigation graph: %dx%d cells, %d nodes, %d links"), SizeX, SizeZ, Graph->Nodes.Num(), Graph->Links.Num());
+	return Graph;
+}
+
+int32 FSampleNavGraph::GetCellNode(int32 X, int32 Z) const
+{
+	if (X < 0 || X >= SizeX || Z < 0 || Z >= SizeZ)
+	{
+		return INDEX_NONE;
+	}
+
+	return CellNodes[Z * SizeX + X];
+}
+
+FVector FSampleNavGraph::GetNodeWorldLocation(int32 Index) const
+{
+	const FVector2D& Location = Nodes[Index].Location;
+	return FVector(Location.X, Params.PlaneY, Location.Y);
+}
+
+int32 FSampleNavGraph::FindNearestNode(const FVector2D& Location) const
+{
+	if (Nodes.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const FVector2D CellLocation = (Location - Params.Bounds.Min) / Params.CellSize;
+	const int32 CellX = FMath::FloorToInt(CellLocation.X);
+	const int32 CellZ = FMath::FloorToInt(CellLocation.Y);
+
+	int32 BestNode = INDEX_NONE;
+	float BestDistanceSqr = MAX_FLT;
+	for (int32 Z = CellZ - SampleNavNearestNodeRadius; Z <= CellZ + SampleNavNearestNodeRadius; ++Z)
+	{
+		for (int32 X = CellX - SampleNavNearestNodeRadius; X <= CellX + SampleNavNearestNodeRadius; ++X)
+		{
+			const int32 NodeIndex = GetCellNode(X, Z);
+			if (NodeIndex != INDEX_NONE)
+			{
+				const float DistanceSqr = FVector2D::DistSquared(Nodes[NodeIndex].Location, Location);
+				if (DistanceSqr < BestDistanceSqr)
+				{
+					BestDistanceSqr = DistanceSqr;
+					BestNode = NodeIndex;
+				}
+			}
+		}
+	}
+
+	return BestNode;
+}
+
+bool FSampleNavGraph::FindPath(int32 Start, int32 Goal, TArray<int32>& OutPath) const
+{
+	OutPath.Reset();
+
+	if (!Nodes.IsValidIndex(Start) || !Nodes.IsValidIndex(Goal))
+	{
+		return false;
+	}
+
+	struct FOpenNode
+	{
+		int32 Node;
+		float Score;
+	};
+
+	auto Less = [](const FOpenNode& A, const FOpenNode& B) { return A.Score < B.Score; };
+
+	// Distance over the fastest speed of any link, admissible so paths are optimal
+	const FVector2D& GoalLocation = Nodes[Goal].Location;
+	auto Heuristic = [this, &GoalLocation](int32 Node) { return FVector2D::Distance(Nodes[Node].Location, GoalLocation) * InvMaxSpeed; };
+
+	TArray<float> Costs;
+	Costs.Init(MAX_FLT, Nodes.Num());
+	TArray<int32> Parents;
+	Parents.Init(INDEX_NONE, Nodes.Num());
+	TBitArray<> Closed(false, Nodes.Num());
+	TArray<FOpenNode> Open;
+
+	Costs[Start] = 0.0f;
+	Open.HeapPush({ Start, Heuristic(Start) }, Less);
+
+	while (Open.Num() > 0)
+	{
+		FOpenNode Current;
+		Open.HeapPop(Current, Less, false);
+
+		if (Current.Node == Goal)
+		{
+			for (int32 Node = Goal; Node != INDEX_NONE; Node = Parents[Node])
+			{
+				OutPath.Add(Node);
+			}
+			Algo::Reverse(OutPath);
+			return true;
+		}
+
+		if (Closed[Current.Node])
+		{
+			continue;
+		}
+
+		Closed[Current.Node] = true;
+
+		const FSampleNavNode& Node = Nodes[Current.Node];
+		for (int32 LinkIndex = Node.FirstLink; LinkIndex < Node.FirstLink + Node.NumLinks; ++LinkIndex)
+		{
+			const FSampleNavLink& Link = Links[LinkIndex];
+			const float Cost = Costs[Current.Node] + Link.Cost;
+			if (!Closed[Link.Target] && Cost < Costs[Link.Target])
+			{
+				Costs[Link.Target] = Cost;
+				Parents[Link.Target] = Current.Node;
+				Open.HeapPush({ Link.Target, Cost + Heuristic(Link.Target) }, Less);
+			}
+		}
+	}
+
+	return false;
+}
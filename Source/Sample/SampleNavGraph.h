@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/** How an AI moves along a link of the navigation graph */
+enum class ESampleNavLinkType : uint8
+{
+	/** Walk on the ground */
+	Walk,
+	/** Climb inside a climbable volume, or grab/leave it */
+	Climb,
+	/** Jump from the ground or from a wall */
+	Jump,
+	/** Walk off a ledge or let go of a wall */
+	Fall
+};
+
+struct FSampleNavLink
+{
+	/** Index of the destination node */
+	int32 Target;
+	/** Estimated travel time in seconds */
+	float Cost;
+	ESampleNavLinkType Type;
+};
+
+struct FSampleNavNode
+{
+	/** Capsule center, X and Z in world space */
+	FVector2D Location;
+	/** Range of outgoing links in FSampleNavGraph::Links */
+	int32 FirstLink;
+	int32 NumLinks;
+	/** The capsule is standing on the ground */
+	uint8 bWalkable : 1;
+	/** The capsule overlaps a climbable volume */
+	uint8 bClimbable : 1;
+};
+
+/** Parameters used to build the graph, usually taken from the character movement */
+struct FSampleNavBuildParams
+{
+	/** Area covered by the graph, in the XZ plane */
+	FBox2D Bounds = FBox2D(ForceInit);
+	/** Depth of the plane the characters are constrained to */
+	float PlaneY = 0.0f;
+	/** Size of a cell, a node is created at the center of each free cell */
+	float CellSize = 32.0f;
+	float CapsuleRadius = 16.0f;
+	float CapsuleHalfHeight = 28.0f;
+	/** Positive gravity, already scaled by GravityScale */
+	float Gravity = 1960.0f;
+	float JumpZVelocity = 800.0f;
+	float MaxWalkSpeed = 225.0f;
+	float MaxClimbSpeed = 100.0f;
+	float ClimbCooldown = 0.0f;
+};
+
+/**
+ * 2D navigation graph built from walkable surfaces, climbable volumes and jump links.
+ *
+ * Once built the graph is immutable, so FindPath can be called from any thread.
+ */
+class SAMPLE_API FSampleNavGraph
+{
+public:
+	/** Build the graph on the game thread by querying the collision of World */
+	static TSharedRef<FSampleNavGraph, ESPMode::ThreadSafe> Build(UWorld* World, const FSampleNavBuildParams& Params);
+
+	/** @return the closest node to Location, or INDEX_NONE */
+	int32 FindNearestNode(const FVector2D& Location) const;
+
+	/** A* search from Start to Goal, OutPath contains node indices including both ends */
+	bool FindPath(int32 Start, int32 Goal, TArray<int32>& OutPath) const;
+
+	FORCEINLINE int32 GetNumNodes() const { return Nodes.Num(); }
+	FORCEINLINE int32 GetNumLinks() const { return Links.Num(); }
+	FORCEINLINE const FSampleNavNode& GetNode(int32 Index) const { return Nodes[Index]; }
+	FORCEINLINE const FSampleNavLink& GetLink(int32 Index) const { return Links[Index]; }
+	FORCEINLINE const FSampleNavBuildParams& GetParams() const { return Params; }
+
+	/** Convert a node to a world location on the character plane */
+	FVector GetNodeWorldLocation(int32 Index) const;
+
+private:
+	int32 GetCellNode(int32 X, int32 Z) const;
+
+	FSampleNavBuildParams Params;
+	/** Number of cells */
+	int32 SizeX = 0;
+	int32 SizeZ = 0;
+	/** Node of each cell, or INDEX_NONE if the cell is blocked */
+	TArray<int32> CellNodes;
+	TArray<FSampleNavNode> Nodes;
+	/** Links grouped by source node */
+	TArray<FSampleNavLink> Links;
+	/** Inverse of the fastest speed of any link, including falls across the bounds, used by the A* heuristic */
+	float InvMaxSpeed = 0.0f;
+};
+
+typedef TSharedPtr<FSampleNavGraph, ESPMode::ThreadSafe> FSampleNavGraphPtr;
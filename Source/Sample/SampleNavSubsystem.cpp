@@ -0,0 +1,293 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleNavSubsystem.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleCharacterMovementComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "DrawDebugHelpers.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Navigation Graph"), STAT_SampleNavBuild, STATGROUP_Sample);
+
+static TAutoConsoleVariable<float> CVarSampleNavCellSize(
+	TEXT("Sample.Nav.CellSize"),
+	32.0f,
+	TEXT("Size of a cell of the climbing navigation graph."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSampleNavPathCacheSize(
+	TEXT("Sample.Nav.PathCacheSize"),
+	8192,
+	TEXT("Maximum number of paths kept in the navigation path cache."),
+	ECVF_Default);
+
+FSampleNavPathCache::FSampleNavPathCache(int32 InMaxEntries)
+	: EvictionRandom(0)
+	, MaxEntries(FMath::Max(1, InMaxEntries))
+{
+	Keys.Reserve(MaxEntries);
+}
+
+bool FSampleNavPathCache::Find(int32 Start, int32 Goal, TArray<int32>& OutPath) const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	if (const FEntry* Entry = Paths.Find(MakeKey(Start, Goal)))
+	{
+		NumHits.Increment();
+		OutPath = Entry->Path;
+		return true;
+	}
+
+	NumMisses.Increment();
+	return false;
+}
+
+void FSampleNavPathCache::Add(int32 Start, int32 Goal, const TArray<int32>& Path)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another agent may have found the same path meanwhile
+	const uint64 Key = MakeKey(Start, Goal);
+	if (FEntry* Entry = Paths.Find(Key))
+	{
+		Entry->Path = Path;
+		return;
+	}
+
+	// Evict a single random path, so a full cache keeps serving the other agents
+	if (Paths.Num() >= MaxEntries)
+	{
+		const int32 Victim = EvictionRandom.RandHelper(Keys.Num());
+		Paths.Remove(Keys[Victim]);
+		Keys.RemoveAtSwap(Victim);
+		if (Keys.IsValidIndex(Victim))
+		{
+			Paths[Keys[Victim]].KeyIndex = Victim;
+		}
+	}
+
+	Paths.Add(Key, FEntry{ Path, Keys.Add(Key) });
+}
+
+void USampleNavSubsystem::BuildGraph()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleNavBuild);
+
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// AI use the same character as players
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	const UClass* PawnClass = (GameMode && GameMode->DefaultPawnClass) ? GameMode->DefaultPawnClass.Get() : ASampleCharacter::StaticClass();
+	const ASampleCharacter* Character = Cast<ASampleCharacter>(PawnClass->GetDefaultObject());
+	if (!Character)
+	{
+		Character = GetDefault<ASampleCharacter>();
+	}
+
+	const USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	FSampleNavBuildParams Params;
+	const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(World->PersistentLevel);
+	Params.Bounds = FBox2D(FVector2D(LevelBounds.Min.X, LevelBounds.Min.Z), FVector2D(LevelBounds.Max.X, LevelBounds.Max.Z));
+	Params.CellSize = CVarSampleNavCellSize.GetValueOnGameThread();
+	Params.CapsuleRadius = Character->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
+	Params.CapsuleHalfHeight = Character->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+
+	if (const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(World, 0))
+	{
+		Params.PlaneY = PlayerPawn->GetActorLocation().Y;
+	}
+
+	if (MoveComponent)
+	{
+		Params.Gravity = FMath::Abs(World->GetGravityZ() * MoveComponent->GravityScale);
+		Params.JumpZVelocity = MoveComponent->JumpZVelocity;
+		Params.MaxWalkSpeed = MoveComponent->MaxWalkSpeed;
+		Params.MaxClimbSpeed = MoveComponent->MaxClimbSpeed;
+		Params.ClimbCooldown = MoveComponent->ClimbCooldown;
+	}
+
+	Graph = FSampleNavGraph::Build(World, Params);
+	PathCache = MakeShared<FSampleNavPathCache, ESPMode::ThreadSafe>(CVarSampleNavPathCacheSize.GetValueOnGameThread());
+}
+
+void USampleNavSubsystem::FindPathAsync(const FVector& Start, const FVector& Goal, FSampleNavPathDelegate OnComplete)
+{
+	if (!Graph.IsValid())
+	{
+		BuildGraph();
+	}
+
+	FSampleNavGraphPtr QueryGraph = Graph;
+	FSampleNavPathCachePtr QueryCache = PathCache;
+	Async(EAsyncExecution::ThreadPool, [QueryGraph, QueryCache, Start, Goal, OnComplete]()
+	{
+		const int32 StartNode = QueryGraph->FindNearestNode(FVector2D(Start.X, Start.Z));
+		const int32 GoalNode = QueryGraph->FindNearestNode(FVector2D(Goal.X, Goal.Z));
+
+		TArray<int32> Nodes;
+		const bool bSuccess = FindPath(*QueryGraph, *QueryCache, StartNode, GoalNode, Nodes);
+
+		TArray<FVector> Path;
+		Path.Reserve(Nodes.Num());
+		for (int32 Node : Nodes)
+		{
+			Path.Add(QueryGraph->GetNodeWorldLocation(Node));
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [OnComplete, bSuccess, Path = MoveTemp(Path)]()
+		{
+			OnComplete.ExecuteIfBound(bSuccess, Path);
+		});
+	});
+}
+
+bool USampleNavSubsystem::FindPath(const FSampleNavGraph& Graph, FSampleNavPathCache& Cache, int32 Start, int32 Goal, TArray<int32>& OutPath)
+{
+	if (Start == INDEX_NONE || Goal == INDEX_NONE)
+	{
+		OutPath.Reset();
+		return false;
+	}
+
+	if (!Cache.Find(Start, Goal, OutPath))
+	{
+		Graph.FindPath(Start, Goal, OutPath);
+		Cache.Add(Start, Goal, OutPath);
+	}
+
+	return OutPath.Num() > 0;
+}
+
+void USampleNavSubsystem::Deinitialize()
+{
+	Graph.Reset();
+	PathCache.Reset();
+
+	Super::Deinitialize();
+}
+
+bool USampleNavSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console commands
+
+static FAutoConsoleCommandWithWorld SampleNavBuildCommand(
+	TEXT("Sample.Nav.Build"),
+	TEXT("Rebuild the climbing navigation graph."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (USampleNavSubsystem* NavSubsystem = World ? World->GetSubsystem<USampleNavSubsystem>() : nullptr)
+		{
+			NavSubsystem->BuildGraph();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SampleNavDrawCommand(
+	TEXT("Sample.Nav.Draw"),
+	TEXT("Draw the climbing navigation graph. Usage: Sample.Nav.Draw [Duration]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USampleNavSubsystem* NavSubsystem = World ? World->GetSubsystem<USampleNavSubsystem>() : nullptr;
+		if (!NavSubsystem)
+		{
+			return;
+		}
+
+		if (!NavSubsystem->GetGraph().IsValid())
+		{
+			NavSubsystem->BuildGraph();
+		}
+
+		const float Duration = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.0f;
+		const FSampleNavGraph& Graph = *NavSubsystem->GetGraph();
+		for (int32 NodeIndex = 0; NodeIndex < Graph.GetNumNodes(); ++NodeIndex)
+		{
+			const FSampleNavNode& Node = Graph.GetNode(NodeIndex);
+			const FVector Location = Graph.GetNodeWorldLocation(NodeIndex);
+			DrawDebugPoint(World, Location, 4.0f, Node.bClimbable ? FColor::Cyan : FColor::Green, false, Duration);
+
+			for (int32 LinkIndex = Node.FirstLink; LinkIndex < Node.FirstLink + Node.NumLinks; ++LinkIndex)
+			{
+				const FSampleNavLink& Link = Graph.GetLink(LinkIndex);
+				const FColor Color = (Link.Type == ESampleNavLinkType::Jump) ? FColor::Orange : (Link.Type == ESampleNavLinkType::Fall) ? FColor::Red : FColor::White;
+				DrawDebugLine(World, Location, Graph.GetNodeWorldLocation(Link.Target), Color, false, Duration);
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SampleNavBenchmarkCommand(
+	TEXT("Sample.Nav.Benchmark"),
+	TEXT("Run path queries for many agents on all cores, with a cold then a warm cache. Usage: Sample.Nav.Benchmark [NumAgents] [QueriesPerAgent]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		USampleNavSubsystem* NavSubsystem = World ? World->GetSubsystem<USampleNavSubsystem>() : nullptr;
+		if (!NavSubsystem)
+		{
+			return;
+		}
+
+		NavSubsystem->BuildGraph();
+
+		const FSampleNavGraph& Graph = *NavSubsystem->GetGraph();
+		const int32 NumAgents = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		const int32 QueriesPerAgent = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10;
+		const int32 NumQueries = NumAgents * QueriesPerAgent;
+		if (Graph.GetNumNodes() == 0 || NumQueries <= 0)
+		{
+			return;
+		}
+
+		// Each agent goes through a few goals shared by the whole team, like AI converging on players
+		FRandomStream Random(NumQueries);
+		TArray<int32> Goals;
+		for (int32 Index = 0; Index < QueriesPerAgent; ++Index)
+		{
+			Goals.Add(Random.RandHelper(Graph.GetNumNodes()));
+		}
+
+		TArray<int32> Starts;
+		for (int32 Index = 0; Index < NumAgents; ++Index)
+		{
+			Starts.Add(Random.RandHelper(Graph.GetNumNodes()));
+		}
+
+		// A cache holding every query, so the warm pass measures hits only. It doesn't touch the
+		// cache of the subsystem, sized by Sample.Nav.PathCacheSize for the game.
+		FSampleNavPathCache Cache(NumQueries);
+
+		for (const TCHAR* Pass : { TEXT("cold"), TEXT("warm") })
+		{
+			const int32 HitsBefore = Cache.GetNumHits();
+			FThreadSafeCounter NumFound;
+
+			const double StartTime = FPlatformTime::Seconds();
+			ParallelFor(NumQueries, [&](int32 Index)
+			{
+				TArray<int32> Path;
+				if (USampleNavSubsystem::FindPath(Graph, Cache, Starts[Index / QueriesPerAgent], Goals[Index % QueriesPerAgent], Path))
+				{
+					NumFound.Increment();
+				}
+			});
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+			UE_LOG(LogSample, Display, TEXT("Nav benchmark (%s cache): %d queries in %.2f ms, %.0f queries/s, %d paths found, %d cache hits"),
+				Pass, NumQueries, Elapsed * 1000.0, NumQueries / FMath::Max(Elapsed, SMALL_NUMBER), NumFound.GetValue(), Cache.GetNumHits() - HitsBefore);
+		}
+	}));
@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SampleNavGraph.h"
+#include "SampleNavSubsystem.generated.h"
+
+DECLARE_DELEGATE_TwoParams(FSampleNavPathDelegate, bool /* bSuccess */, const TArray<FVector>& /* Path */);
+
+/**
+ * Cache of the paths found in a navigation graph, shared by all queries and safe to use from any thread.
+ * Unreachable goals are cached as empty paths.
+ */
+class SAMPLE_API FSampleNavPathCache
+{
+public:
+	explicit FSampleNavPathCache(int32 InMaxEntries);
+
+	/** @return true if a result is cached for this query, OutPath is empty if the goal is unreachable */
+	bool Find(int32 Start, int32 Goal, TArray<int32>& OutPath) const;
+
+	/** Store the result of a query, a random path is evicted once the cache reaches its maximum size */
+	void Add(int32 Start, int32 Goal, const TArray<int32>& Path);
+
+	FORCEINLINE int32 GetNumHits() const { return NumHits.GetValue(); }
+	FORCEINLINE int32 GetNumMisses() const { return NumMisses.GetValue(); }
+
+private:
+	static FORCEINLINE uint64 MakeKey(int32 Start, int32 Goal) { return ((uint64)(uint32)Start << 32) | (uint32)Goal; }
+
+	struct FEntry
+	{
+		TArray<int32> Path;
+		/** Index of the key in Keys */
+		int32 KeyIndex;
+	};
+
+	mutable FRWLock Lock;
+	TMap<uint64, FEntry> Paths;
+	/** Keys of Paths, to pick an eviction victim in constant time */
+	TArray<uint64> Keys;
+	FRandomStream EvictionRandom;
+	int32 MaxEntries;
+	mutable FThreadSafeCounter NumHits;
+	mutable FThreadSafeCounter NumMisses;
+};
+
+typedef TSharedPtr<FSampleNavPathCache, ESPMode::ThreadSafe> FSampleNavPathCachePtr;
+
+/**
+ * Owns the climbing navigation graph of a world and answers path queries for AI.
+ *
+ * The engine navmesh doesn't know about MOVE_Climbing, this graph is built from the level
+ * collision, the climbable volumes and the movement settings of the default pawn.
+ */
+UCLASS()
+class USampleNavSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Build the graph from the level and the movement settings of the default pawn class */
+	void BuildGraph();
+
+	/** Find a path on a worker thread, OnComplete is called on the game thread */
+	void FindPathAsync(const FVector& Start, const FVector& Goal, FSampleNavPathDelegate OnComplete);
+
+	/** Find a path between two nodes through the cache, can be called from any thread */
+	static bool FindPath(const FSampleNavGraph& Graph, FSampleNavPathCache& Cache, int32 Start, int32 Goal, TArray<int32>& OutPath);
+
+	FORCEINLINE FSampleNavGraphPtr GetGraph() const { return Graph; }
+	FORCEINLINE FSampleNavPathCachePtr GetPathCache() const { return PathCache; }
+
+	virtual void Deinitialize() override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Immutable once built, replaced as a whole when rebuilt so running queries keep their graph */
+	FSampleNavGraphPtr Graph;
+
+	/** Paths of the current graph */
+	FSampleNavPathCachePtr PathCache;
+};
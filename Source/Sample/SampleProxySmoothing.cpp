@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleProxySmoothing.h"
+
+/** How fast the server time offset follows the latest updates */
+static const float SampleServerTimeOffsetBlend = 0.1f;
+
+FSampleProxySmoothing::FSampleProxySmoothing()
+	: Head(0)
+	, NumSamples(0)
+	, ServerTimeOffset(0.0f)
+{}
+
+void FSampleProxySmoothing::AddSample(float ServerTime, float LocalTime, const FVector& Location, const FVector& Velocity, uint8 Mode)
+{
+	if (NumSamples > 0 && ServerTime <= GetSample(NumSamples - 1).ServerTime)
+	{
+		return;
+	}
+
+	const float Offset = LocalTime - ServerTime;
+	ServerTimeOffset = (NumSamples == 0) ? Offset : FMath::Lerp(ServerTimeOffset, Offset, SampleServerTimeOffsetBlend);
+
+	FSampleProxySample* Sample;
+	if (NumSamples < MaxSamples)
+	{
+		Sample = &Samples[(Head + NumSamples) % MaxSamples];
+		++NumSamples;
+	}
+	else
+	{
+		// Overwrite the oldest sample
+		Sample = &Samples[Head];
+		Head = (Head + 1) % MaxSamples;
+	}
+
+	Sample->ServerTime = ServerTime;
+	Sample->Location = FVector2f((float)Location.X, (float)Location.Z);
+	Sample->Velocity[0] = (int16)FMath::Clamp(FMath::RoundToInt(Velocity.X), (int32)MIN_int16, (int32)MAX_int16);
+	Sample->Velocity[1] = (int16)FMath::Clamp(FMath::RoundToInt(Velocity.Z), (int32)MIN_int16, (int32)MAX_int16);
+	Sample->Mode = Mode;
+}
+
+void FSampleProxySmoothing::Reset()
+{
+	Head = 0;
+	NumSamples = 0;
+}
+
+const FSampleProxySample& FSampleProxySmoothing::GetSample(int32 Index) const
+{
+	return Samples[(Head + Index) % MaxSamples];
+}
+
+FVector2D FSampleProxySmoothing::Extrapolate(const FSampleProxySample& Sample, float DeltaTime, float Gravity)
+{
+	FVector2D Location = FVector2D(Sample.Location) + FVector2D(Sample.Velocity[0], Sample.Velocity[1]) * DeltaTime;
+	if (Sample.Mode == ModeFalling)
+	{
+		Location.Y -= 0.5f * Gravity * DeltaTime * DeltaTime;
+	}
+
+	return Location;
+}
+
+bool FSampleProxySmoothing::Evaluate(float LocalTime, float InterpolationDelay, float MaxExtrapolationTime, float Gravity, FVector2D& OutLocation) const
+{
+	if (NumSamples == 0)
+	{
+		return false;
+	}
+
+	const float RenderTime = LocalTime - ServerTimeOffset - InterpolationDelay;
+
+	// Before the oldest sample
+	const FSampleProxySample& Oldest = GetSample(0);
+	if (RenderTime <= Oldest.ServerTime)
+	{
+		OutLocation = FVector2D(Oldest.Location);
+		return true;
+	}
+
+	// After the newest sample
+	const FSampleProxySample& Newest = GetSample(NumSamples - 1);
+	if (RenderTime >= Newest.ServerTime)
+	{
+		OutLocation = Extrapolate(Newest, FMath::Min(RenderTime - Newest.ServerTime, MaxExtrapolationTime), Gravity);
+		return true;
+	}
+
+	int32 Index = NumSamples - 2;
+	while (Index > 0 && GetSample(Index).ServerTime > RenderTime)
+	{
+		--Index;
+	}
+
+	const FSampleProxySample& From = GetSample(Index);
+	const FSampleProxySample& To = GetSample(Index + 1);
+	const float Duration = To.ServerTime - From.ServerTime;
+	const float ElapsedTime = RenderTime - From.ServerTime;
+	const float Alpha = FMath::Clamp(ElapsedTime / Duration, 0.0f, 1.0f);
+
+	if (From.Mode == To.Mode)
+	{
+		// Hermite spline using the replicated velocities
+		const FVector2D FromTangent = FVector2D(From.Velocity[0], From.Velocity[1]) * Duration;
+		const FVector2D ToTangent = FVector2D(To.Velocity[0], To.Velocity[1]) * Duration;
+		OutLocation = FMath::CubicInterp(FVector2D(From.Location), FromTangent, FVector2D(To.Location), ToTangent, Alpha);
+	}
+	else
+	{
+		// Keep the motion of the previous mode and converge to the next sample
+		const FVector2D Extrapolated = Extrapolate(From, ElapsedTime, Gravity);
+		const FVector2D Interpolated = FMath::Lerp(FVector2D(From.Location), FVector2D(To.Location), Alpha);
+		OutLocation = FMath::Lerp(Extrapolated, Interpolated, Alpha);
+	}
+
+	return true;
+}
@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One replicated movement update of a simulated proxy */
+struct FSampleProxySample
+{
+	/** Server time of the update */
+	float ServerTime;
+	/** X and Z location */
+	FVector2f Location;
+	/** X and Z velocity, in cm/s */
+	int16 Velocity[2];
+	/** Movement mode, one of FSampleProxySmoothing::ModeGround, ModeFalling or ModeClimbing */
+	uint8 Mode;
+};
+
+/**
+ * Timestamped history of the replicated movement of a simulated proxy, used to draw it
+ * slightly in the past between two known positions.
+ *
+ * Samples with the same movement mode are interpolated along the XZ plane using their
+ * velocities. Across a movement mode change (starting or ending a climb, jumping off a wall)
+ * the motion of the previous mode is extrapolated and blended into the next sample, so the
+ * proxy follows the climb or the jump instead of cutting the corner.
+ */
+class SAMPLE_API FSampleProxySmoothing
+{
+public:
+	enum : uint8
+	{
+		ModeGround = 0,
+		ModeFalling = 1,
+		ModeClimbing = 2
+	};
+
+	static const int32 MaxSamples = 8;
+
+	FSampleProxySmoothing();
+
+	/** Add a replicated update received at LocalTime, older or duplicated updates are ignored */
+	void AddSample(float ServerTime, float LocalTime, const FVector& Location, const FVector& Velocity, uint8 Mode);
+
+	/** Forget all samples, when teleporting */
+	void Reset();
+
+	/**
+	 * Compute the location to draw at LocalTime.
+	 * @param Gravity - Positive gravity applied when extrapolating a fall
+	 */
+	bool Evaluate(float LocalTime, float InterpolationDelay, float MaxExtrapolationTime, float Gravity, FVector2D& OutLocation) const;
+
+	FORCEINLINE int32 GetNumSamples() const { return NumSamples; }
+
+private:
+	const FSampleProxySample& GetSample(int32 Index) const;
+	static FVector2D Extrapolate(const FSampleProxySample& Sample, float DeltaTime, float Gravity);
+
+	/** Ring buffer, oldest sample at Head */
+	FSampleProxySample Samples[MaxSamples];
+	uint8 Head;
+	uint8 NumSamples;
+	/** Estimated LocalTime - ServerTime */
+	float ServerTimeOffset;
+};
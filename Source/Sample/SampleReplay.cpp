@@ -0,0 +1,386 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleReplay.h"
+#include "SampleCharacter.h"
+#include "Misc/FileHelper.h"
+#include "Algo/BinarySearch.h"
+
+/** Identify replay files, "SRP2" */
+static const uint32 SampleReplayMagic = 0x32505253;
+
+/** Size of the header: magic, sample rate, quantization and plane */
+static const int32 SampleReplayHeaderSize = sizeof(uint32) + 3 * sizeof(float);
+
+/** Size of the footer: checkpoint count, frame count and magic */
+static const int32 SampleReplayFooterSize = 3 * sizeof(uint32);
+
+/** Size of a checkpoint in the index */
+static const int32 SampleReplayCheckpointSize = sizeof(int32) + sizeof(int64);
+
+enum ESampleReplayFrameType : uint8
+{
+	SampleReplayFrame_Delta = 0,
+	SampleReplayFrame_Checkpoint = 1
+};
+
+enum ESampleReplayRecordFlags : uint8
+{
+	SampleReplayRecord_Position = 0x1,
+	SampleReplayRecord_State = 0x2,
+	SampleReplayRecord_Removed = 0x4,
+	SampleReplayRecord_Added = 0x8
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Encoding
+
+static void SampleReplayWriteByte(TArray<uint8>& Data, uint8 Value)
+{
+	Data.Add(Value);
+}
+
+static void SampleReplayWriteVarUInt(TArray<uint8>& Data, uint32 Value)
+{
+	while (Value >= 0x80)
+	{
+		Data.Add((uint8)(Value | 0x80));
+		Value >>= 7;
+	}
+	Data.Add((uint8)Value);
+}
+
+static void SampleReplayWriteVarInt(TArray<uint8>& Data, int32 Value)
+{
+	// Zigzag so small negative values are small too
+	SampleReplayWriteVarUInt(Data, ((uint32)Value << 1) ^ (uint32)(Value >> 31));
+}
+
+template<typename T>
+static void SampleReplayWriteRaw(TArray<uint8>& Data, T Value)
+{
+	Data.Append((const uint8*)&Value, sizeof(T));
+}
+
+static bool SampleReplayReadByte(const TArray<uint8>& Data, int64& Offset, uint8& OutValue)
+{
+	if (Offset >= Data.Num())
+	{
+		return false;
+	}
+	OutValue = Data[Offset++];
+	return true;
+}
+
+static bool SampleReplayReadVarUInt(const TArray<uint8>& Data, int64& Offset, uint32& OutValue)
+{
+	OutValue = 0;
+	for (int32 Shift = 0; Shift < 35; Shift += 7)
+	{
+		uint8 Byte;
+		if (!SampleReplayReadByte(Data, Offset, Byte))
+		{
+			return false;
+		}
+
+		OutValue |= (uint32)(Byte & 0x7F) << Shift;
+		if ((Byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool SampleReplayReadVarInt(const TArray<uint8>& Data, int64& Offset, int32& OutValue)
+{
+	uint32 Value;
+	if (!SampleReplayReadVarUInt(Data, Offset, Value))
+	{
+		return false;
+	}
+	OutValue = (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	return true;
+}
+
+template<typename T>
+static T SampleReplayReadRaw(const TArray<uint8>& Data, int64 Offset)
+{
+	T Value;
+	FMemory::Memcpy(&Value, Data.GetData() + Offset, sizeof(T));
+	return Value;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSampleReplayCharacterState
+
+uint8 FSampleReplayCharacterState::PackState(ESampleReplayMovementMode Mode, bool bFacingLeft, ESampleAnimationState Animation)
+{
+	return ((uint8)Mode & 0x3) | (bFacingLeft ? 0x4 : 0x0) | (((uint8)Animation & 0x3) << 3);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSampleReplayRecorder
+
+FSampleReplayRecorder::FSampleReplayRecorder(float InSampleRate, float InCheckpointInterval, float InQuantization, float InPlaneY)
+	: SampleRate(FMath::Max(InSampleRate, 1.0f))
+	, Quantization(FMath::Max(InQuantization, KINDA_SMALL_NUMBER))
+	, PlaneY(InPlaneY)
+	, CheckpointFrames(FMath::Max(1, FMath::RoundToInt(InCheckpointInterval * SampleRate)))
+{
+	SampleReplayWriteRaw(Data, SampleReplayMagic);
+	SampleReplayWriteRaw(Data, SampleRate);
+	SampleReplayWriteRaw(Data, Quantization);
+	SampleReplayWriteRaw(Data, PlaneY);
+}
+
+void FSampleReplayRecorder::AddFrame(const FSampleReplayFrame& Frame)
+{
+	NumCharacterFrames += Frame.Num();
+
+	if (NumFrames % CheckpointFrames == 0)
+	{
+		Checkpoints.Add({ NumFrames, Data.Num() });
+
+		SampleReplayWriteByte(Data, SampleReplayFrame_Checkpoint);
+		SampleReplayWriteVarUInt(Data, Frame.Num());
+		for (const TPair<uint32, FSampleReplayCharacterState>& Pair : Frame)
+		{
+			SampleReplayWriteVarUInt(Data, Pair.Key);
+			SampleReplayWriteVarInt(Data, Pair.Value.X);
+			SampleReplayWriteVarInt(Data, Pair.Value.Z);
+			SampleReplayWriteByte(Data, Pair.Value.State);
+		}
+	}
+	else
+	{
+		// Count the records first to write them without a temporary buffer
+		uint32 NumRecords = 0;
+		for (const TPair<uint32, FSampleReplayCharacterState>& Pair : Frame)
+		{
+			const FSampleReplayCharacterState* Previous = PreviousFrame.Find(Pair.Key);
+			NumRecords += (!Previous || *Previous != Pair.Value) ? 1 : 0;
+		}
+		for (const TPair<uint32, FSampleReplayCharacterState>& Pair : PreviousFrame)
+		{
+			NumRecords += Frame.Contains(Pair.Key) ? 0 : 1;
+		}
+
+		SampleReplayWriteByte(Data, SampleReplayFrame_Delta);
+		SampleReplayWriteVarUInt(Data, NumRecords);
+
+		for (const TPair<uint32, FSampleReplayCharacterState>& Pair : Frame)
+		{
+			const FSampleReplayCharacterState& State = Pair.Value;
+			const FSampleReplayCharacterState* Previous = PreviousFrame.Find(Pair.Key);
+			if (!Previous)
+			{
+				SampleReplayWriteVarUInt(Data, Pair.Key);
+				SampleReplayWriteByte(Data, SampleReplayRecord_Added);
+				SampleReplayWriteVarInt(Data, State.X);
+				SampleReplayWriteVarInt(Data, State.Z);
+				SampleReplayWriteByte(Data, State.State);
+			}
+			else if (*Previous != State)
+			{
+				const bool bPositionChanged = Previous->X != State.X || Previous->Z != State.Z;
+				const bool bStateChanged = Previous->State != State.State;
+
+				SampleReplayWriteVarUInt(Data, Pair.Key);
+				SampleReplayWriteByte(Data, (uint8)((bPositionChanged ? SampleReplayRecord_Position : 0) | (bStateChanged ? SampleReplayRecord_State : 0)));
+				if (bPositionChanged)
+				{
+					SampleReplayWriteVarInt(Data, State.X - Previous->X);
+					SampleReplayWriteVarInt(Data, State.Z - Previous->Z);
+				}
+				if (bStateChanged)
+				{
+					SampleReplayWriteByte(Data, State.State);
+				}
+			}
+		}
+
+		for (const TPair<uint32, FSampleReplayCharacterState>& Pair : PreviousFrame)
+		{
+			if (!Frame.Contains(Pair.Key))
+			{
+				SampleReplayWriteVarUInt(Data, Pair.Key);
+				SampleReplayWriteByte(Data, SampleReplayRecord_Removed);
+			}
+		}
+	}
+
+	PreviousFrame = Frame;
+	++NumFrames;
+}
+
+bool FSampleReplayRecorder::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Index;
+	Index.Reserve(Checkpoints.Num() * SampleReplayCheckpointSize + SampleReplayFooterSize);
+	for (const FSampleReplayCheckpoint& Checkpoint : Checkpoints)
+	{
+		SampleReplayWriteRaw(Index, Checkpoint.Frame);
+		SampleReplayWriteRaw(Index, Checkpoint.Offset);
+	}
+	SampleReplayWriteRaw(Index, (uint32)Checkpoints.Num());
+	SampleReplayWriteRaw(Index, (uint32)NumFrames);
+	SampleReplayWriteRaw(Index, SampleReplayMagic);
+
+	TArray<uint8> File;
+	File.Reserve(Data.Num() + Index.Num());
+	File.Append(Data);
+	File.Append(Index);
+	return FFileHelper::SaveArrayToFile(File, *Filename);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSampleReplayReader
+
+bool FSampleReplayReader::LoadFromFile(const FString& Filename)
+{
+	Data.Reset();
+	Checkpoints.Reset();
+	Frame.Reset();
+	CurrentFrame = INDEX_NONE;
+	NumFrames = 0;
+
+	if (!FFileHelper::LoadFileToArray(Data, *Filename) || Data.Num() < SampleReplayHeaderSize + SampleReplayFooterSize)
+	{
+		return false;
+	}
+
+	if (SampleReplayReadRaw<uint32>(Data, 0) != SampleReplayMagic || SampleReplayReadRaw<uint32>(Data, Data.Num() - sizeof(uint32)) != SampleReplayMagic)
+	{
+		return false;
+	}
+
+	SampleRate = SampleReplayReadRaw<float>(Data, sizeof(uint32));
+	Quantization = SampleReplayReadRaw<float>(Data, sizeof(uint32) + sizeof(float));
+	PlaneY = SampleReplayReadRaw<float>(Data, sizeof(uint32) + 2 * sizeof(float));
+
+	const int64 FooterOffset = Data.Num() - SampleReplayFooterSize;
+	const uint32 NumCheckpoints = SampleReplayReadRaw<uint32>(Data, FooterOffset);
+	NumFrames = (int32)SampleReplayReadRaw<uint32>(Data, FooterOffset + sizeof(uint32));
+
+	const int64 IndexOffset = FooterOffset - (int64)NumCheckpoints * SampleReplayCheckpointSize;
+	if (IndexOffset < SampleReplayHeaderSize || SampleRate <= 0.0f || Quantization <= 0.0f)
+	{
+		return false;
+	}
+
+	Checkpoints.Reserve(NumCheckpoints);
+	for (uint32 Index = 0; Index < NumCheckpoints; ++Index)
+	{
+		const int64 Offset = IndexOffset + (int64)Index * SampleReplayCheckpointSize;
+		const FSampleReplayCheckpoint Checkpoint = { SampleReplayReadRaw<int32>(Data, Offset), SampleReplayReadRaw<int64>(Data, Offset + sizeof(int32)) };
+
+		// Seeking trusts the index, reject a corrupted one. The first checkpoint is the first frame.
+		if (Checkpoint.Offset < SampleReplayHeaderSize || Checkpoint.Offset >= IndexOffset || Checkpoint.Frame < 0 || Checkpoint.Frame >= NumFrames
+			|| (Checkpoints.Num() == 0 ? Checkpoint.Frame != 0 : Checkpoint.Frame <= Checkpoints.Last().Frame))
+		{
+			Checkpoints.Reset();
+			return false;
+		}
+
+		Checkpoints.Add(Checkpoint);
+	}
+
+	// The index isn't needed anymore
+	Data.SetNum((int32)IndexOffset);
+	return Checkpoints.Num() > 0;
+}
+
+bool FSampleReplayReader::Seek(float Time)
+{
+	if (Checkpoints.Num() == 0 || NumFrames == 0)
+	{
+		return false;
+	}
+
+	const int32 TargetFrame = FMath::Clamp(FMath::FloorToInt(Time * SampleRate), 0, NumFrames - 1);
+
+	// Closest checkpoint before the target
+	const int32 CheckpointIndex = FMath::Max(0, Algo::UpperBoundBy(Checkpoints, TargetFrame, &FSampleReplayCheckpoint::Frame) - 1);
+	const FSampleReplayCheckpoint& Checkpoint = Checkpoints[CheckpointIndex];
+
+	if (CurrentFrame == INDEX_NONE || CurrentFrame > TargetFrame || CurrentFrame < Checkpoint.Frame)
+	{
+		CurrentFrame = Checkpoint.Frame - 1;
+		ReadOffset = Checkpoint.Offset;
+	}
+
+	while (CurrentFrame < TargetFrame)
+	{
+		if (!DecodeNextFrame())
+		{
+			CurrentFrame = INDEX_NONE;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FSampleReplayReader::DecodeNextFrame()
+{
+	uint8 Type;
+	uint32 NumRecords;
+	if (!SampleReplayReadByte(Data, ReadOffset, Type) || !SampleReplayReadVarUInt(Data, ReadOffset, NumRecords))
+	{
+		return false;
+	}
+
+	if (Type == SampleReplayFrame_Checkpoint)
+	{
+		Frame.Reset();
+	}
+
+	for (uint32 Record = 0; Record < NumRecords; ++Record)
+	{
+		uint32 Id;
+		if (!SampleReplayReadVarUInt(Data, ReadOffset, Id))
+		{
+			return false;
+		}
+
+		uint8 Flags = SampleReplayRecord_Added;
+		if (Type == SampleReplayFrame_Delta && !SampleReplayReadByte(Data, ReadOffset, Flags))
+		{
+			return false;
+		}
+
+		if (Flags & SampleReplayRecord_Removed)
+		{
+			Frame.Remove(Id);
+		}
+		else if (Flags & SampleReplayRecord_Added)
+		{
+			FSampleReplayCharacterState& State = Frame.FindOrAdd(Id);
+			if (!SampleReplayReadVarInt(Data, ReadOffset, State.X) || !SampleReplayReadVarInt(Data, ReadOffset, State.Z) || !SampleReplayReadByte(Data, ReadOffset, State.State))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			FSampleReplayCharacterState& State = Frame.FindOrAdd(Id);
+			if (Flags & SampleReplayRecord_Position)
+			{
+				int32 DeltaX, DeltaZ;
+				if (!SampleReplayReadVarInt(Data, ReadOffset, DeltaX) || !SampleReplayReadVarInt(Data, ReadOffset, DeltaZ))
+				{
+					return false;
+				}
+				State.X += DeltaX;
+				State.Z += DeltaZ;
+			}
+			if ((Flags & SampleReplayRecord_State) && !SampleReplayReadByte(Data, ReadOffset, State.State))
+			{
+				return false;
+			}
+		}
+	}
+
+	++CurrentFrame;
+	return true;
+}
@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ESampleAnimationState : uint8;
+
+/** Movement mode stored in a replay */
+enum class ESampleReplayMovementMode : uint8
+{
+	Ground,
+	Falling,
+	Climbing,
+	Other
+};
+
+/** State of one character in one replay frame */
+struct SAMPLE_API FSampleReplayCharacterState
+{
+	/** Location on the XZ plane, in multiples of the replay quantization */
+	int32 X = 0;
+	int32 Z = 0;
+	/** Movement mode, facing and animation state packed in a byte */
+	uint8 State = 0;
+
+	static uint8 PackState(ESampleReplayMovementMode Mode, bool bFacingLeft, ESampleAnimationState Animation);
+
+	ESampleReplayMovementMode GetMovementMode() const { return (ESampleReplayMovementMode)(State & 0x3); }
+	bool IsFacingLeft() const { return (State & 0x4) != 0; }
+	ESampleAnimationState GetAnimationState() const { return (ESampleAnimationState)((State >> 3) & 0x3); }
+
+	bool operator==(const FSampleReplayCharacterState& Other) const { return X == Other.X && Z == Other.Z && State == Other.State; }
+	bool operator!=(const FSampleReplayCharacterState& Other) const { return !(*this == Other); }
+};
+
+typedef TMap<uint32, FSampleReplayCharacterState> FSampleReplayFrame;
+
+/** Frame from which a replay can be decoded without the previous frames */
+struct FSampleReplayCheckpoint
+{
+	int32 Frame;
+	int64 Offset;
+};
+
+/**
+ * Compact replay format storing one track per character, sampled at a fixed rate: frame N
+ * is at N / SampleRate seconds.
+ *
+ * Frames only contain the characters that changed since the previous frame, with positions
+ * as variable length deltas. Every checkpoint interval a frame with the absolute state of all
+ * characters is written, and the offsets of these checkpoints are stored at the end of the
+ * file, so seeking only decodes the frames since the closest checkpoint.
+ */
+class SAMPLE_API FSampleReplayRecorder
+{
+public:
+	/** @param InPlaneY - Y of the plane the characters move on, recorded once */
+	FSampleReplayRecorder(float InSampleRate, float InCheckpointInterval, float InQuantization, float InPlaneY);
+
+	/** Add the next frame, characters missing from Frame are considered removed */
+	void AddFrame(const FSampleReplayFrame& Frame);
+
+	/** Write the frames and the checkpoint index */
+	bool SaveToFile(const FString& Filename) const;
+
+	FORCEINLINE int32 GetNumFrames() const { return NumFrames; }
+	FORCEINLINE int64 GetNumCharacterFrames() const { return NumCharacterFrames; }
+	FORCEINLINE int64 GetDataSize() const { return Data.Num(); }
+	FORCEINLINE float GetQuantization() const { return Quantization; }
+	FORCEINLINE float GetSampleRate() const { return SampleRate; }
+	FORCEINLINE float GetPlaneY() const { return PlaneY; }
+
+private:
+	float SampleRate;
+	float Quantization;
+	float PlaneY;
+	int32 CheckpointFrames;
+	int32 NumFrames = 0;
+	int64 NumCharacterFrames = 0;
+	TArray<uint8> Data;
+	TArray<FSampleReplayCheckpoint> Checkpoints;
+	FSampleReplayFrame PreviousFrame;
+};
+
+/** Decode a replay written by FSampleReplayRecorder */
+class SAMPLE_API FSampleReplayReader
+{
+public:
+	bool LoadFromFile(const FString& Filename);
+
+	/** Decode the frame at Time, continuing from the current frame when it is closer than the previous checkpoint */
+	bool Seek(float Time);
+
+	FORCEINLINE const FSampleReplayFrame& GetFrame() const { return Frame; }
+	FORCEINLINE float GetDuration() const { return NumFrames / SampleRate; }
+	FORCEINLINE float GetQuantization() const { return Quantization; }
+	FORCEINLINE float GetPlaneY() const { return PlaneY; }
+	FORCEINLINE int64 GetDataSize() const { return Data.Num(); }
+
+private:
+	bool DecodeNextFrame();
+
+	TArray<uint8> Data;
+	TArray<FSampleReplayCheckpoint> Checkpoints;
+	float SampleRate = 0.0f;
+	float Quantization = 1.0f;
+	float PlaneY = 0.0f;
+	int32 NumFrames = 0;
+
+	/** Frame decoded last, and where the next one starts */
+	FSampleReplayFrame Frame;
+	int32 CurrentFrame = INDEX_NONE;
+	int64 ReadOffset = 0;
+};
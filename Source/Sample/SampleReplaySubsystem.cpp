@@ -0,0 +1,374 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleReplaySubsystem.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleCharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Record Replay Frame"), STAT_SampleReplayRecord, STATGROUP_Sample);
+DECLARE_CYCLE_STAT(TEXT("Seek Replay"), STAT_SampleReplaySeek, STATGROUP_Sample);
+
+static TAutoConsoleVariable<float> CVarSampleReplaySampleRate(
+	TEXT("Sample.Replay.SampleRate"),
+	30.0f,
+	TEXT("Frames per second recorded by Sample.Replay.Record."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSampleReplayCheckpointInterval(
+	TEXT("Sample.Replay.CheckpointInterval"),
+	1.0f,
+	TEXT("Seconds between two checkpoints of a replay, a seek decodes at most this long."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSampleReplayQuantization(
+	TEXT("Sample.Replay.Quantization"),
+	1.0f,
+	TEXT("Precision of the positions recorded in a replay, in unreal units."),
+	ECVF_Default);
+
+void USampleReplaySubsystem::StartRecording(const FString& Name)
+{
+	StopRecording();
+	StopPlayback();
+
+	// Characters all move on the plane of the local pawn, or of any character on a server
+	UWorld* World = GetWorld();
+	float PlaneY = 0.0f;
+	const APlayerController* PlayerController = World->GetFirstPlayerController();
+	if (const APawn* LocalPawn = PlayerController ? PlayerController->GetPawn() : nullptr)
+	{
+		PlaneY = LocalPawn->GetActorLocation().Y;
+	}
+	else
+	{
+		TActorIterator<ASampleCharacter> It(World);
+		if (It)
+		{
+			PlaneY = It->GetActorLocation().Y;
+		}
+	}
+
+	Recorder = MakeUnique<FSampleReplayRecorder>(
+		CVarSampleReplaySampleRate.GetValueOnGameThread(),
+		CVarSampleReplayCheckpointInterval.GetValueOnGameThread(),
+		CVarSampleReplayQuantization.GetValueOnGameThread(),
+		PlaneY);
+	RecordingFilename = GetReplayFilename(Name);
+	RecordAccumulator = 0.0f;
+	RecordedIds.Reset();
+	NextRecordedId = 0;
+
+	RecordFrames(1);
+
+	UE_LOG(LogSample, Display, TEXT("Recording replay to %s"), *RecordingFilename);
+}
+
+void USampleReplaySubsystem::StopRecording()
+{
+	if (!Recorder)
+	{
+		return;
+	}
+
+	if (!Recorder->SaveToFile(RecordingFilename))
+	{
+		UE_LOG(LogSample, Error, TEXT("Failed to write replay %s"), *RecordingFilename);
+	}
+	else
+	{
+		const double PlayerMinutes = Recorder->GetNumCharacterFrames() / Recorder->GetSampleRate() / 60.0;
+		UE_LOG(LogSample, Display, TEXT("Replay %s: %d frames, %d characters, %lld bytes, %.0f bytes per player-minute"),
+			*RecordingFilename, Recorder->GetNumFrames(), NextRecordedId, Recorder->GetDataSize(),
+			PlayerMinutes > 0.0 ? Recorder->GetDataSize() / PlayerMinutes : 0.0);
+	}
+
+	Recorder.Reset();
+	RecordedIds.Reset();
+}
+
+bool USampleReplaySubsystem::StartPlayback(const FString& Name)
+{
+	StopRecording();
+	StopPlayback();
+
+	Reader = MakeUnique<FSampleReplayReader>();
+	if (!Reader->LoadFromFile(GetReplayFilename(Name)))
+	{
+		UE_LOG(LogSample, Error, TEXT("Failed to read replay %s"), *GetReplayFilename(Name));
+		Reader.Reset();
+		return false;
+	}
+
+	SeekPlayback(0.0f);
+	return true;
+}
+
+void USampleReplaySubsystem::StopPlayback()
+{
+	for (const TPair<uint32, ASampleCharacter*>& Pair : Ghosts)
+	{
+		if (IsValid(Pair.Value))
+		{
+			Pair.Value->Destroy();
+		}
+	}
+
+	Ghosts.Empty();
+	Reader.Reset();
+}
+
+void USampleReplaySubsystem::SeekPlayback(float Time)
+{
+	if (!Reader)
+	{
+		return;
+	}
+
+	PlaybackTime = FMath::Clamp(Time, 0.0f, Reader->GetDuration());
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SampleReplaySeek);
+		Reader->Seek(PlaybackTime);
+	}
+
+	ApplyPlaybackFrame();
+}
+
+void USampleReplaySubsystem::Benchmark(const FString& Name, int32 NumSeeks)
+{
+	const double LoadStart = FPlatformTime::Seconds();
+	FSampleReplayReader BenchmarkReader;
+	if (!BenchmarkReader.LoadFromFile(GetReplayFilename(Name)))
+	{
+		UE_LOG(LogSample, Error, TEXT("Failed to read replay %s"), *GetReplayFilename(Name));
+		return;
+	}
+	const double LoadTime = FPlatformTime::Seconds() - LoadStart;
+
+	// Use a fixed seed so benchmarks are comparable
+	FRandomStream Random(NumSeeks);
+	double TotalTime = 0.0;
+	double MaxTime = 0.0;
+	for (int32 Index = 0; Index < NumSeeks; ++Index)
+	{
+		const double Start = FPlatformTime::Seconds();
+		BenchmarkReader.Seek(Random.FRand() * BenchmarkReader.GetDuration());
+		const double Time = FPlatformTime::Seconds() - Start;
+
+		TotalTime += Time;
+		MaxTime = FMath::Max(MaxTime, Time);
+	}
+
+	UE_LOG(LogSample, Display, TEXT("Replay %s: %.1f s, %lld bytes, loaded in %.2f ms, %d seeks: %.3f ms average, %.3f ms max"),
+		*Name, BenchmarkReader.GetDuration(), BenchmarkReader.GetDataSize(), LoadTime * 1000.0,
+		NumSeeks, NumSeeks > 0 ? TotalTime * 1000.0 / NumSeeks : 0.0, MaxTime * 1000.0);
+}
+
+FString USampleReplaySubsystem::GetReplayFilename(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("SampleReplays") / (Name + TEXT(".sreplay"));
+}
+
+FSampleReplayCharacterState USampleReplaySubsystem::CaptureState(const ASampleCharacter* Character, float Quantization)
+{
+	ESampleReplayMovementMode Mode = ESampleReplayMovementMode::Other;
+	const USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetCharacterMovement());
+	if (MoveComponent && MoveComponent->IsClimbing())
+	{
+		Mode = ESampleReplayMovementMode::Climbing;
+	}
+	else if (MoveComponent && MoveComponent->IsFalling())
+	{
+		Mode = ESampleReplayMovementMode::Falling;
+	}
+	else if (MoveComponent && MoveComponent->IsMovingOnGround())
+	{
+		Mode = ESampleReplayMovementMode::Ground;
+	}
+
+	const FVector Location = Character->GetActorLocation();
+	const bool bFacingLeft = FMath::Abs(FRotator::NormalizeAxis(Character->GetActorRotation().Yaw)) > 90.0f;
+
+	FSampleReplayCharacterState State;
+	State.X = FMath::RoundToInt(Location.X / Quantization);
+	State.Z = FMath::RoundToInt(Location.Z / Quantization);
+	State.State = FSampleReplayCharacterState::PackState(Mode, bFacingLeft, Character->GetAnimationState());
+	return State;
+}
+
+void USampleReplaySubsystem::RecordFrames(int32 NumFrames)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleReplayRecord);
+
+	FSampleReplayFrame Frame;
+	for (TActorIterator<ASampleCharacter> It(GetWorld()); It; ++It)
+	{
+		ASampleCharacter* Character = *It;
+		if (Character->IsActorBeingDestroyed())
+		{
+			continue;
+		}
+
+		uint32* Id = RecordedIds.Find(Character);
+		if (!Id)
+		{
+			Id = &RecordedIds.Add(Character, NextRecordedId++);
+		}
+
+		Frame.Add(*Id, CaptureState(Character, Recorder->GetQuantization()));
+	}
+
+	// Frames after the first one are empty deltas
+	for (int32 Index = 0; Index < NumFrames; ++Index)
+	{
+		Recorder->AddFrame(Frame);
+	}
+}
+
+void USampleReplaySubsystem::ApplyPlaybackFrame()
+{
+	UWorld* World = GetWorld();
+	const FSampleReplayFrame& Frame = Reader->GetFrame();
+	const float Quantization = Reader->GetQuantization();
+
+	// Characters that left the match are hidden rather than destroyed, to be shown again when seeking back
+	for (const TPair<uint32, ASampleCharacter*>& Pair : Ghosts)
+	{
+		if (IsValid(Pair.Value))
+		{
+			Pair.Value->SetActorHiddenInGame(!Frame.Contains(Pair.Key));
+		}
+	}
+
+	for (const TPair<uint32, FSampleReplayCharacterState>& Pair : Frame)
+	{
+		const FSampleReplayCharacterState& State = Pair.Value;
+		const FVector Location(State.X * Quantization, Reader->GetPlaneY(), State.Z * Quantization);
+
+		ASampleCharacter*& Ghost = Ghosts.FindOrAdd(Pair.Key);
+		if (!IsValid(Ghost))
+		{
+			const AGameModeBase* GameMode = World->GetAuthGameMode();
+			UClass* GhostClass = (GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf<ASampleCharacter>()) ? GameMode->DefaultPawnClass.Get() : ASampleCharacter::StaticClass();
+
+			// Ghosts only display the replay, they neither move, collide nor replicate
+			const FTransform Transform(Location);
+			Ghost = World->SpawnActorDeferred<ASampleCharacter>(GhostClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			if (!Ghost)
+			{
+				continue;
+			}
+
+			Ghost->SetReplicates(false);
+			Ghost->AutoPossessAI = EAutoPossessAI::Disabled;
+			Ghost->FinishSpawning(Transform);
+			Ghost->SetActorTickEnabled(false);
+			Ghost->SetActorEnableCollision(false);
+			Ghost->GetCharacterMovement()->Deactivate();
+		}
+
+		Ghost->SetReplayState(Location, State.IsFacingLeft(), State.GetAnimationState());
+	}
+}
+
+void USampleReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+	StopPlayback();
+
+	Super::Deinitialize();
+}
+
+void USampleReplaySubsystem::Tick(float DeltaTime)
+{
+	if (Recorder)
+	{
+		// Frame N is played at N / SampleRate, so record every frame due since the last tick
+		// even when ticking slower than the sample rate or on hitches
+		const float SampleInterval = 1.0f / Recorder->GetSampleRate();
+		RecordAccumulator += DeltaTime;
+		const int32 NumFrames = FMath::FloorToInt(RecordAccumulator / SampleInterval);
+		if (NumFrames > 0)
+		{
+			RecordAccumulator -= NumFrames * SampleInterval;
+			RecordFrames(NumFrames);
+		}
+	}
+
+	if (Reader && PlaybackTime < Reader->GetDuration())
+	{
+		SeekPlayback(PlaybackTime + DeltaTime);
+	}
+}
+
+TStatId USampleReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USampleReplaySubsystem, STATGROUP_Tickables);
+}
+
+bool USampleReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console commands
+
+static FAutoConsoleCommandWithWorldAndArgs SampleReplayRecordCommand(
+	TEXT("Sample.Replay.Record"),
+	TEXT("Record the characters to Saved/SampleReplays. Usage: Sample.Replay.Record [Name]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USampleReplaySubsystem* Replay = World ? World->GetSubsystem<USampleReplaySubsystem>() : nullptr)
+		{
+			Replay->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("Replay"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld SampleReplayStopCommand(
+	TEXT("Sample.Replay.Stop"),
+	TEXT("Stop recording or playing a replay."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (USampleReplaySubsystem* Replay = World ? World->GetSubsystem<USampleReplaySubsystem>() : nullptr)
+		{
+			Replay->StopRecording();
+			Replay->StopPlayback();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SampleReplayPlayCommand(
+	TEXT("Sample.Replay.Play"),
+	TEXT("Play a replay with ghost characters. Usage: Sample.Replay.Play [Name]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USampleReplaySubsystem* Replay = World ? World->GetSubsystem<USampleReplaySubsystem>() : nullptr)
+		{
+			Replay->StartPlayback(Args.Num() > 0 ? Args[0] : TEXT("Replay"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs SampleReplaySeekCommand(
+	TEXT("Sample.Replay.Seek"),
+	TEXT("Jump to a time in the replay being played. Usage: Sample.Replay.Seek Seconds"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (USampleReplaySubsystem* Replay = World ? World->GetSubsystem<USampleReplaySubsystem>() : nullptr)
+		{
+			Replay->SeekPlayback(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithArgs SampleReplayBenchmarkCommand(
+	TEXT("Sample.Replay.Benchmark"),
+	TEXT("Log the latency of random seeks in a replay. Usage: Sample.Replay.Benchmark [Name] [NumSeeks]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		USampleReplaySubsystem::Benchmark(Args.Num() > 0 ? Args[0] : TEXT("Replay"), Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000);
+	}));
@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SampleReplay.h"
+#include "SampleReplaySubsystem.generated.h"
+
+class ASampleCharacter;
+
+/**
+ * Records the characters of a world to a compact replay in Saved/SampleReplays, and plays
+ * it back with ghost characters that only display the recorded position, facing and animation.
+ *
+ * Runs alongside the engine demo recording rather than replacing it: only what is needed to
+ * review a match is kept, at Sample.Replay.SampleRate frames per second.
+ */
+UCLASS()
+class USampleReplaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Record every character of the world until StopRecording, stops the playback */
+	void StartRecording(const FString& Name);
+
+	/** Write the replay and log its size per player-minute */
+	void StopRecording();
+
+	/** Spawn a ghost for each recorded character and play the replay from the start, stops the recording */
+	bool StartPlayback(const FString& Name);
+	void StopPlayback();
+
+	/** Jump to Time seconds in the replay being played */
+	void SeekPlayback(float Time);
+
+	/** Seek NumSeeks random times in a replay and log the latency */
+	static void Benchmark(const FString& Name, int32 NumSeeks);
+
+	static FString GetReplayFilename(const FString& Name);
+
+	/** Capture the replay state of a character */
+	static FSampleReplayCharacterState CaptureState(const ASampleCharacter* Character, float Quantization);
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Capture the characters and add them NumFrames times, to keep the replay in time when ticking slower than the sample rate */
+	void RecordFrames(int32 NumFrames);
+	void ApplyPlaybackFrame();
+
+	TUniquePtr<FSampleReplayRecorder> Recorder;
+	FString RecordingFilename;
+	float RecordAccumulator = 0.0f;
+
+	/** Track of each recorded character */
+	TMap<TWeakObjectPtr<ASampleCharacter>, uint32> RecordedIds;
+	uint32 NextRecordedId = 0;
+
+	TUniquePtr<FSampleReplayReader> Reader;
+	float PlaybackTime = 0.0f;
+
+	/** Character displaying each track of the replay being played */
+	UPROPERTY(Transient)
+	TMap<uint32, ASampleCharacter*> Ghosts;
+};
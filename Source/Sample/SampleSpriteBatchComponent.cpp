@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleSpriteBatchComponent.h"
+#include "PaperSprite.h"
+
+USampleSpriteBatchComponent::USampleSpriteBatchComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// Only used for rendering
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+}
+
+bool USampleSpriteBatchComponent::UpdateInstanceSprite(int32 InstanceIndex, UPaperSprite* Sprite)
+{
+	if (!PerInstanceSpriteData.IsValidIndex(InstanceIndex))
+	{
+		return false;
+	}
+
+	FSpriteInstanceData& InstanceData = PerInstanceSpriteData[InstanceIndex];
+	if (InstanceData.SourceSprite == Sprite)
+	{
+		return false;
+	}
+
+	InstanceData.SourceSprite = Sprite;
+	InstanceData.MaterialIndex = Sprite ? InstanceMaterials.AddUnique(Sprite->GetDefaultMaterial()) : INDEX_NONE;
+	return true;
+}
+
+bool USampleSpriteBatchComponent::RemoveInstanceSwap(int32 InstanceIndex)
+{
+	const int32 LastIndex = PerInstanceSpriteData.Num() - 1;
+	if (!PerInstanceSpriteData.IsValidIndex(InstanceIndex))
+	{
+		return false;
+	}
+
+	if (InstanceIndex != LastIndex)
+	{
+		PerInstanceSpriteData[InstanceIndex] = PerInstanceSpriteData[LastIndex];
+	}
+
+	// Removing the last instance doesn't shift any other instance
+	return RemoveInstance(LastIndex);
+}
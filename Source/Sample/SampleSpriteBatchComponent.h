@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "SampleSpriteBatchComponent.generated.h"
+
+class UPaperSprite;
+
+/**
+ * Grouped sprite component allowing to change the sprite of an instance, so a flipbook
+ * can be played per instance without owning a UPaperFlipbookComponent.
+ */
+UCLASS(ClassGroup = "Sample")
+class USampleSpriteBatchComponent : public UPaperGroupedSpriteComponent
+{
+	GENERATED_BODY()
+
+public:
+	USampleSpriteBatchComponent(const FObjectInitializer& ObjectInitializer);
+
+	/** Change the sprite displayed by an instance, the render state must be marked dirty by the caller */
+	bool UpdateInstanceSprite(int32 InstanceIndex, UPaperSprite* Sprite);
+
+	/** Remove an instance by moving the last instance in its slot, so other instance indices stay valid */
+	bool RemoveInstanceSwap(int32 InstanceIndex);
+};
@@ -0,0 +1,182 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleSpriteBatchSubsystem.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleSpriteBatchComponent.h"
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Sprite Batches"), STAT_SampleUpdateSpriteBatches, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Sprites"), STAT_SampleBatchedSprites, STATGROUP_Sample);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sprite Batch Render State Updates"), STAT_SampleSpriteBatchRenderStateUpdates, STATGROUP_Sample);
+
+static TAutoConsoleVariable<int32> CVarSampleSpriteBatching(
+	TEXT("Sample.SpriteBatching"),
+	0,
+	TEXT("If 1, simulated proxies are drawn through one grouped sprite component per character class."),
+	ECVF_Default);
+
+bool USampleSpriteBatchSubsystem::IsEnabled()
+{
+	return CVarSampleSpriteBatching.GetValueOnGameThread() != 0;
+}
+
+void USampleSpriteBatchSubsystem::AddCharacter(ASampleCharacter* Character)
+{
+	UWorld* World = GetWorld();
+	if (!World || !Character)
+	{
+		return;
+	}
+
+	if (!BatchActor)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		BatchActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+	}
+
+	FSampleSpriteBatch& Batch = Batches.FindOrAdd(Character->GetClass());
+	if (!Batch.Component)
+	{
+		Batch.Component = NewObject<USampleSpriteBatchComponent>(BatchActor);
+		Batch.Component->RegisterComponent();
+	}
+
+	UPaperFlipbookComponent* Sprite = Character->GetSprite();
+	UPaperFlipbook* Flipbook = Character->GetDesiredAnimation();
+	const FTransform Transform = Sprite->GetRelativeTransform() * Character->GetActorTransform();
+
+	Batch.Component->AddInstance(Transform, Flipbook ? Flipbook->GetSpriteAtFrame(0) : nullptr, true);
+	Batch.Characters.Add(Character);
+	Batch.Flipbooks.Add(Flipbook);
+	Batch.PlaybackTimes.Add(0.0f);
+	Batch.FrameIndices.Add(0);
+
+	Character->SetSpriteBatched(true);
+}
+
+void USampleSpriteBatchSubsystem::RemoveCharacter(ASampleCharacter* Character)
+{
+	FSampleSpriteBatch* Batch = Character ? Batches.Find(Character->GetClass()) : nullptr;
+	if (!Batch)
+	{
+		return;
+	}
+
+	const int32 Index = Batch->Characters.IndexOfByKey(Character);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Same swap as in the component to keep the packed arrays in sync with instances
+	Batch->Component->RemoveInstanceSwap(Index);
+	Batch->Characters.RemoveAtSwap(Index);
+	Batch->Flipbooks.RemoveAtSwap(Index);
+	Batch->PlaybackTimes.RemoveAtSwap(Index);
+	Batch->FrameIndices.RemoveAtSwap(Index);
+
+	Character->SetSpriteBatched(false);
+}
+
+void USampleSpriteBatchSubsystem::Deinitialize()
+{
+	if (BatchActor)
+	{
+		BatchActor->Destroy();
+		BatchActor = nullptr;
+	}
+
+	Batches.Empty();
+
+	Super::Deinitialize();
+}
+
+void USampleSpriteBatchSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleUpdateSpriteBatches);
+
+	for (TPair<UClass*, FSampleSpriteBatch>& Pair : Batches)
+	{
+		UpdateBatch(Pair.Value, DeltaTime);
+	}
+}
+
+void USampleSpriteBatchSubsystem::UpdateBatch(FSampleSpriteBatch& Batch, float DeltaTime)
+{
+	// A proxy possessed by the local player after BeginPlay draws its own flipbook again.
+	// Iterate backward as removing swaps the last character in the slot.
+	for (int32 Index = Batch.Characters.Num() - 1; Index >= 0; --Index)
+	{
+		if (Batch.Characters[Index]->GetLocalRole() != ROLE_SimulatedProxy)
+		{
+			RemoveCharacter(Batch.Characters[Index]);
+		}
+	}
+
+	const int32 Num = Batch.Characters.Num();
+	if (Num == 0)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_SampleBatchedSprites, Num);
+
+	bool bRenderStateDirty = false;
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		ASampleCharacter* Character = Batch.Characters[Index];
+
+		// Restart the playback when the motion requires another flipbook
+		UPaperFlipbook* Flipbook = Character->GetDesiredAnimation();
+		float& PlaybackTime = Batch.PlaybackTimes[Index];
+		if (Flipbook != Batch.Flipbooks[Index])
+		{
+			Batch.Flipbooks[Index] = Flipbook;
+			Batch.FrameIndices[Index] = INDEX_NONE;
+			PlaybackTime = 0.0f;
+		}
+
+		if (Flipbook)
+		{
+			const float Duration = Flipbook->GetTotalDuration();
+			PlaybackTime = (Duration > 0.0f) ? FMath::Fmod(PlaybackTime + DeltaTime, Duration) : 0.0f;
+
+			const int32 FrameIndex = Flipbook->GetKeyFrameIndexAtTime(PlaybackTime);
+			if (FrameIndex != Batch.FrameIndices[Index])
+			{
+				Batch.FrameIndices[Index] = FrameIndex;
+				bRenderStateDirty |= Batch.Component->UpdateInstanceSprite(Index, Flipbook->GetSpriteAtFrame(FrameIndex));
+			}
+		}
+
+		const FTransform Transform = Character->GetSprite()->GetRelativeTransform() * Character->GetActorTransform();
+		FTransform InstanceTransform;
+		if (!Batch.Component->GetInstanceTransform(Index, InstanceTransform, true) || !InstanceTransform.Equals(Transform))
+		{
+			Batch.Component->UpdateInstanceTransform(Index, Transform, true, false);
+			bRenderStateDirty = true;
+		}
+	}
+
+	// Recreate a single render proxy for the whole batch, only when an instance changed
+	if (bRenderStateDirty)
+	{
+		Batch.Component->MarkRenderStateDirty();
+		INC_DWORD_STAT(STAT_SampleSpriteBatchRenderStateUpdates);
+	}
+}
+
+TStatId USampleSpriteBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USampleSpriteBatchSubsystem, STATGROUP_Tickables);
+}
+
+bool USampleSpriteBatchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SampleSpriteBatchSubsystem.generated.h"
+
+class ASampleCharacter;
+class UPaperFlipbook;
+class USampleSpriteBatchComponent;
+
+/**
+ * Characters drawn by one USampleSpriteBatchComponent. Arrays are packed and indexed
+ * by the instance index in the component.
+ */
+USTRUCT()
+struct FSampleSpriteBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	USampleSpriteBatchComponent* Component = nullptr;
+
+	UPROPERTY(Transient)
+	TArray<ASampleCharacter*> Characters;
+
+	UPROPERTY(Transient)
+	TArray<UPaperFlipbook*> Flipbooks;
+
+	TArray<float> PlaybackTimes;
+
+	TArray<int32> FrameIndices;
+};
+
+/**
+ * Optional renderer drawing all simulated proxies through one grouped sprite component per
+ * character class (each class defining its own set of flipbooks), instead of one
+ * UPaperFlipbookComponent per character.
+ *
+ * Enabled with Sample.SpriteBatching 1, taken into account when characters begin play.
+ */
+UCLASS()
+class USampleSpriteBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** @return true if simulated proxies should be batched */
+	static bool IsEnabled();
+
+	/** Start drawing a character through the batch of its class */
+	void AddCharacter(ASampleCharacter* Character);
+
+	/** Stop drawing a character through its batch */
+	void RemoveCharacter(ASampleCharacter* Character);
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Drop characters that are no longer simulated proxies, advance the flipbooks and push the changed transforms and sprites to the component */
+	void UpdateBatch(FSampleSpriteBatch& Batch, float DeltaTime);
+
+	/** Actor owning the batch components */
+	UPROPERTY(Transient)
+	AActor* BatchActor;
+
+	UPROPERTY(Transient)
+	TMap<UClass*, FSampleSpriteBatch> Batches;
+};
@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleTrainingCommandlet.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleTrainingEnvironment.h"
+
+USampleTrainingCommandlet::USampleTrainingCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 USampleTrainingCommandlet::Main(const FString& Params)
+{
+	int32 NumWorlds = 64;
+	int32 NumSteps = 1000;
+	int32 Seed = 0;
+	float DeltaTime = 1.0f / 60.0f;
+	FString CharacterPath = TEXT("/Game/Mario/BP_MarioCharacter.BP_MarioCharacter_C");
+
+	FParse::Value(*Params, TEXT("Worlds="), NumWorlds);
+	FParse::Value(*Params, TEXT("Steps="), NumSteps);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Delta="), DeltaTime);
+	FParse::Value(*Params, TEXT("Character="), CharacterPath);
+
+	// The blueprint sets the flipbooks and the climbing settings
+	TSubclassOf<ASampleCharacter> CharacterClass = LoadClass<ASampleCharacter>(nullptr, *CharacterPath);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogSample, Warning, TEXT("Failed to load %s, using ASampleCharacter"), *CharacterPath);
+		CharacterClass = ASampleCharacter::StaticClass();
+	}
+
+	USampleTrainingEnvironment* Environment = NewObject<USampleTrainingEnvironment>();
+	Environment->AddToRoot();
+	Environment->FixedDeltaTime = DeltaTime;
+
+	const double CreateStartTime = FPlatformTime::Seconds();
+	Environment->CreateWorlds(NumWorlds, CharacterClass, FSampleTrainingLayout::MakeDefault());
+	const double CreateTime = FPlatformTime::Seconds() - CreateStartTime;
+
+	TArray<FSampleTrainingObservation> Observations;
+	Environment->Reset(Observations);
+
+	// Random actions held for a few steps, like an exploring policy
+	FRandomStream Random(Seed);
+	TArray<FSampleTrainingAction> Actions;
+	Actions.SetNum(NumWorlds);
+
+	int32 NumClimbingSteps = 0;
+	const double StepStartTime = FPlatformTime::Seconds();
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		for (FSampleTrainingAction& Action : Actions)
+		{
+			if (Random.FRand() < 0.1f)
+			{
+				Action.MoveRight = Random.FRandRange(-1.0f, 1.0f);
+				Action.MoveUp = Random.FRandRange(-1.0f, 1.0f);
+				Action.bJump = Random.FRand() < 0.2f;
+				Action.bClimb = Random.FRand() < 0.7f;
+			}
+		}
+
+		Environment->Step(Actions, Observations);
+
+		for (const FSampleTrainingObservation& Observation : Observations)
+		{
+			NumClimbingSteps += Observation.bClimbing ? 1 : 0;
+		}
+	}
+	const double StepTime = FPlatformTime::Seconds() - StepStartTime;
+
+	const int64 NumEnvironmentSteps = (int64)NumWorlds * NumSteps;
+	UE_LOG(LogSample, Display, TEXT("Created %d worlds in %.2f ms"), NumWorlds, CreateTime * 1000.0);
+	UE_LOG(LogSample, Display, TEXT("%lld environment steps in %.2f s: %.0f steps/s, %.1f%% of steps climbing"),
+		NumEnvironmentSteps, StepTime, NumEnvironmentSteps / FMath::Max(StepTime, SMALL_NUMBER), 100.0 * NumClimbingSteps / FMath::Max<int64>(NumEnvironmentSteps, 1));
+
+	Environment->DestroyWorlds();
+	Environment->RemoveFromRoot();
+	return 0;
+}
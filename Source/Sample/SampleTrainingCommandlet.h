@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SampleTrainingCommandlet.generated.h"
+
+/**
+ * Step headless training environments with random actions and report the throughput.
+ *
+ * Usage: -run=SampleTraining [-Worlds=64] [-Steps=1000] [-Delta=0.0166] [-Seed=0] [-Character=/Game/...]
+ *
+ * Worlds are ticked on a single thread, run one process per core with a different
+ * -Seed to measure the throughput across cores.
+ */
+UCLASS()
+class USampleTrainingCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USampleTrainingCommandlet(const FObjectInitializer& ObjectInitializer);
+
+	virtual int32 Main(const FString& Params) override;
+};
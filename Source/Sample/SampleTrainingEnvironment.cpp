@@ -0,0 +1,223 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SampleTrainingEnvironment.h"
+#include "Sample.h"
+#include "SampleCharacter.h"
+#include "SampleCharacterMovementComponent.h"
+#include "SampleClimbableVolume.h"
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "UObject/Package.h"
+
+DECLARE_CYCLE_STAT(TEXT("Training Step"), STAT_SampleTrainingStep, STATGROUP_Sample);
+
+FSampleTrainingLayout FSampleTrainingLayout::MakeDefault()
+{
+	FSampleTrainingLayout Layout;
+	Layout.Solids.Add(FBox(FVector(-1024.0f, -64.0f, -32.0f), FVector(1024.0f, 64.0f, 0.0f)));
+	Layout.Solids.Add(FBox(FVector(320.0f, -64.0f, 384.0f), FVector(640.0f, 64.0f, 416.0f)));
+	Layout.Climbables.Add(FBox(FVector(224.0f, -16.0f, 0.0f), FVector(288.0f, 16.0f, 448.0f)));
+	Layout.SpawnLocation = FVector(0.0f, 0.0f, 64.0f);
+	return Layout;
+}
+
+void USampleTrainingEnvironment::CreateWorlds(int32 NumWorlds, TSubclassOf<ASampleCharacter> CharacterClass, const FSampleTrainingLayout& InLayout)
+{
+	DestroyWorlds();
+
+	Layout = InLayout;
+	if (!CharacterClass)
+	{
+		CharacterClass = ASampleCharacter::StaticClass();
+	}
+
+	for (int32 WorldIndex = 0; WorldIndex < NumWorlds; ++WorldIndex)
+	{
+		CreateWorld(WorldIndex, CharacterClass);
+	}
+
+	PreviousActions.SetNum(Worlds.Num());
+}
+
+UWorld* USampleTrainingEnvironment::CreateWorld(int32 WorldIndex, TSubclassOf<ASampleCharacter> CharacterClass)
+{
+	// Only what the character movement needs
+	UWorld::InitializationValues InitValues = UWorld::InitializationValues()
+		.AllowAudioPlayback(false)
+		.RequiresHitProxies(false)
+		.CreatePhysicsScene(true)
+		.CreateNavigation(false)
+		.CreateAISystem(false)
+		.ShouldSimulatePhysics(false)
+		.EnableTraceCollision(true)
+		.SetTransactional(false)
+		.CreateFXSystem(false);
+
+	const FName WorldName = MakeUniqueObjectName(GetTransientPackage(), UWorld::StaticClass(), *FString::Printf(TEXT("SampleTraining_%d"), WorldIndex));
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, WorldName, nullptr, false, ERHIFeatureLevel::Num, &InitValues);
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (const FBox& Solid : Layout.Solids)
+	{
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Solid.GetCenter()), SpawnParams);
+		UBoxComponent* Box = NewObject<UBoxComponent>(Actor);
+		Box->SetBoxExtent(Solid.GetExtent(), false);
+		Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Box->SetGenerateOverlapEvents(false);
+		Box->SetMobility(EComponentMobility::Static);
+		Actor->SetRootComponent(Box);
+		Box->RegisterComponent();
+		Actor->SetActorLocation(Solid.GetCenter());
+	}
+
+	for (const FBox& Climbable : Layout.Climbables)
+	{
+		ASampleClimbableVolume* Volume = World->SpawnActor<ASampleClimbableVolume>(ASampleClimbableVolume::StaticClass(), FTransform(Climbable.GetCenter()), SpawnParams);
+		if (!Volume->GetRootComponent())
+		{
+			Volume->SetRootComponent(Volume->GetBoxComponent());
+		}
+		Volume->GetBoxComponent()->SetBoxExtent(Climbable.GetExtent());
+		Volume->SetActorLocation(Climbable.GetCenter());
+	}
+
+	ASampleCharacter* Character = World->SpawnActor<ASampleCharacter>(CharacterClass, FTransform(Layout.SpawnLocation), SpawnParams);
+
+	// There is no controller to possess the character
+	Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+
+	// No game mode, start play directly
+	World->GetWorldSettings()->NotifyBeginPlay();
+
+	Worlds.Add(World);
+	Characters.Add(Character);
+	return World;
+}
+
+void USampleTrainingEnvironment::DestroyWorlds()
+{
+	for (UWorld* World : Worlds)
+	{
+		if (World)
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+	}
+
+	Worlds.Reset();
+	Characters.Reset();
+	PreviousActions.Reset();
+}
+
+void USampleTrainingEnvironment::Reset(TArray<FSampleTrainingObservation>& OutObservations)
+{
+	for (int32 WorldIndex = 0; WorldIndex < Worlds.Num(); ++WorldIndex)
+	{
+		ResetWorld(WorldIndex);
+	}
+
+	Observe(OutObservations);
+}
+
+void USampleTrainingEnvironment::ResetWorld(int32 WorldIndex)
+{
+	ASampleCharacter* Character = Characters[WorldIndex];
+	USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	Character->StopJumping();
+	Character->StopClimb();
+	Character->TeleportTo(Layout.SpawnLocation, FRotator::ZeroRotator, false, true);
+
+	MoveComponent->StopMovementImmediately();
+	MoveComponent->SetMovementMode(MOVE_Falling);
+	MoveComponent->ClimbTimer = 0.0f;
+	MoveComponent->ClimbGrabTimer = 0.0f;
+	MoveComponent->ClimbCoyoteTimer = 0.0f;
+
+	PreviousActions[WorldIndex] = FSampleTrainingAction();
+}
+
+void USampleTrainingEnvironment::ApplyAction(int32 WorldIndex, const FSampleTrainingAction& Action)
+{
+	ASampleCharacter* Character = Characters[WorldIndex];
+	const FSampleTrainingAction& PreviousAction = PreviousActions[WorldIndex];
+
+	// Same as the input bindings of ASampleCharacter
+	if (Action.bJump && !PreviousAction.bJump)
+	{
+		Character->Jump();
+	}
+	else if (!Action.bJump && PreviousAction.bJump)
+	{
+		Character->StopJumping();
+	}
+
+	if (Action.bClimb && !PreviousAction.bClimb)
+	{
+		Character->StartClimb();
+	}
+	else if (!Action.bClimb && PreviousAction.bClimb)
+	{
+		Character->StopClimb();
+	}
+
+	Character->AddMovementInput(FVector(1.0f, 0.0f, 0.0f), FMath::Clamp(Action.MoveRight, -1.0f, 1.0f));
+
+	const USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetCharacterMovement());
+	if (MoveComponent && MoveComponent->IsClimbing())
+	{
+		Character->AddMovementInput(FVector(0.0f, 0.0f, 1.0f), FMath::Clamp(Action.MoveUp, -1.0f, 1.0f));
+	}
+
+	PreviousActions[WorldIndex] = Action;
+}
+
+void USampleTrainingEnvironment::Step(const TArray<FSampleTrainingAction>& Actions, TArray<FSampleTrainingObservation>& OutObservations)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SampleTrainingStep);
+
+	check(Actions.Num() == Worlds.Num());
+
+	for (int32 WorldIndex = 0; WorldIndex < Worlds.Num(); ++WorldIndex)
+	{
+		ApplyAction(WorldIndex, Actions[WorldIndex]);
+
+		// Actors reading GWorld must see the world being ticked
+		UWorld* World = Worlds[WorldIndex];
+		TGuardValue<UWorldProxy, UWorld*> WorldGuard(GWorld, World);
+		World->Tick(LEVELTICK_All, FixedDeltaTime);
+	}
+
+	Observe(OutObservations);
+}
+
+void USampleTrainingEnvironment::Observe(TArray<FSampleTrainingObservation>& OutObservations) const
+{
+	OutObservations.SetNum(Characters.Num());
+
+	for (int32 WorldIndex = 0; WorldIndex < Characters.Num(); ++WorldIndex)
+	{
+		const ASampleCharacter* Character = Characters[WorldIndex];
+		const USampleCharacterMovementComponent* MoveComponent = Cast<USampleCharacterMovementComponent>(Character->GetCharacterMovement());
+		const FVector Location = Character->GetActorLocation();
+		const FVector Velocity = MoveComponent->Velocity;
+
+		FSampleTrainingObservation& Observation = OutObservations[WorldIndex];
+		Observation.Location = FVector2D(Location.X, Location.Z);
+		Observation.Velocity = FVector2D(Velocity.X, Velocity.Z);
+		Observation.bClimbing = MoveComponent->IsClimbing();
+		Observation.bClimbEnabled = MoveComponent->bClimbEnabled;
+		Observation.bFalling = MoveComponent->IsFalling();
+		Observation.ClimbTimer = MoveComponent->ClimbTimer;
+	}
+}
@@ -0,0 +1,143 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "SampleTrainingEnvironment.generated.h"
+
+class ASampleCharacter;
+class UWorld;
+
+/** Inputs applied to the character of one environment for one step */
+USTRUCT(BlueprintType)
+struct FSampleTrainingAction
+{
+	GENERATED_BODY()
+
+	/** Same as the MoveRight axis, in [-1, 1] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	float MoveRight = 0.0f;
+
+	/** Same as the MoveUp axis, in [-1, 1], only used while climbing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	float MoveUp = 0.0f;
+
+	/** If the Jump button is held */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	bool bJump = false;
+
+	/** If the Climb button is held */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	bool bClimb = false;
+};
+
+/** State of the character of one environment after a step */
+USTRUCT(BlueprintType)
+struct FSampleTrainingObservation
+{
+	GENERATED_BODY()
+
+	/** X and Z location */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	FVector2D Location = FVector2D::ZeroVector;
+
+	/** X and Z velocity */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	FVector2D Velocity = FVector2D::ZeroVector;
+
+	/** If in MOVE_Climbing */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	bool bClimbing = false;
+
+	/** If overlapping a climbable volume */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	bool bClimbEnabled = false;
+
+	/** If in MOVE_Falling */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	bool bFalling = false;
+
+	/** Remaining cooldown before climbing again */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Training)
+	float ClimbTimer = 0.0f;
+};
+
+/** Boxes making the level of each environment, in the XZ plane */
+USTRUCT(BlueprintType)
+struct FSampleTrainingLayout
+{
+	GENERATED_BODY()
+
+	/** Blocking geometry */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	TArray<FBox> Solids;
+
+	/** Climbable volumes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	TArray<FBox> Climbables;
+
+	/** Where the character starts each episode */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Training)
+	FVector SpawnLocation = FVector::ZeroVector;
+
+	/** A floor, a climbable wall and a platform reachable by climbing */
+	static FSampleTrainingLayout MakeDefault();
+};
+
+/**
+ * Headless environments for training bots and tuning the climbing movement.
+ *
+ * Creates many small independent game worlds without rendering, audio, navigation or AI,
+ * each containing one character driven without controller, and steps them at a fixed delta
+ * with batched actions and observations.
+ *
+ * Worlds are ticked on the game thread, one after the other, as UWorld::Tick isn't thread
+ * safe. Use several processes (see USampleTrainingCommandlet) to use all cores.
+ */
+UCLASS()
+class USampleTrainingEnvironment : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Create NumWorlds environments with the given character class and layout */
+	void CreateWorlds(int32 NumWorlds, TSubclassOf<ASampleCharacter> CharacterClass, const FSampleTrainingLayout& InLayout);
+
+	/** Destroy all environments, must be called when done as the engine keeps a context for each world */
+	void DestroyWorlds();
+
+	/** Move every character back to the spawn location */
+	void Reset(TArray<FSampleTrainingObservation>& OutObservations);
+
+	/** Move one character back to the spawn location, for episodes ending at different times */
+	void ResetWorld(int32 WorldIndex);
+
+	/** Apply one action per environment, tick every world by FixedDeltaTime and gather the observations */
+	void Step(const TArray<FSampleTrainingAction>& Actions, TArray<FSampleTrainingObservation>& OutObservations);
+
+	/** Gather the observations without stepping */
+	void Observe(TArray<FSampleTrainingObservation>& OutObservations) const;
+
+	FORCEINLINE int32 GetNumWorlds() const { return Worlds.Num(); }
+	FORCEINLINE UWorld* GetTrainingWorld(int32 WorldIndex) const { return Worlds[WorldIndex]; }
+
+	/** Simulated time of each step */
+	UPROPERTY(EditAnywhere, Category = Training)
+	float FixedDeltaTime = 1.0f / 60.0f;
+
+private:
+	UWorld* CreateWorld(int32 WorldIndex, TSubclassOf<ASampleCharacter> CharacterClass);
+	void ApplyAction(int32 WorldIndex, const FSampleTrainingAction& Action);
+
+	UPROPERTY(Transient)
+	TArray<UWorld*> Worlds;
+
+	UPROPERTY(Transient)
+	TArray<ASampleCharacter*> Characters;
+
+	/** Action of the previous step, to detect button presses and releases */
+	TArray<FSampleTrainingAction> PreviousActions;
+
+	FSampleTrainingLayout Layout;
+};